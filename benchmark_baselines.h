@@ -0,0 +1,269 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_BASELINES_H_
+#define BENCHMARK_BASELINES_H_
+
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace fenwick {
+namespace bench {
+
+// Reference structures the benchmarks compare the Fenwick trees against. They
+// follow the same conventions: a fictive array a[1..n] of 0s at start, n =
+// 2^m - 1 for the sums, any n for the RMQs.
+
+// Keeps the prefix sums themselves.
+struct PrefixArray {
+  explicit PrefixArray(int m) : n((1 << m) - 1), sums(n + 1, 0LL) {}
+
+  // Replaces the array with a[1..n].
+  // Complexity: O(n)
+  void construct(const int64_t* a) {
+    for (int i = 1; i <= n; i++) {
+      sums[i] = sums[i - 1] + a[i];
+    }
+  }
+
+  // Complexity: O(1)
+  int64_t prefix_sum(int idx) const { return sums[idx]; }
+  // Complexity: O(1)
+  int64_t range_sum(int l, int r) const { return sums[r] - sums[l - 1]; }
+  // Adds delta to a[idx].
+  // Complexity: O(n)
+  void update(int idx, int64_t delta) {
+    for (int i = idx; i <= n; i++) {
+      sums[i] += delta;
+    }
+  }
+
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(*this) + sums.capacity() * sizeof(int64_t);
+  }
+
+  int n;
+  std::vector<int64_t> sums;
+};
+
+// Iterative (bottom-up) segment tree: the leaves are t[size..2 size), a[i] is
+// at t[size + i - 1], and every inner node p is t[2p] + t[2p + 1].
+struct SegmentTree {
+  explicit SegmentTree(int m)
+      : n((1 << m) - 1), size(1 << m), t(2 * size, 0LL) {}
+
+  // Replaces the array with a[1..n].
+  // Complexity: O(n)
+  void construct(const int64_t* a) {
+    std::copy(a + 1, a + n + 1, t.begin() + size);
+    for (int p = size - 1; p >= 1; p--) {
+      t[p] = t[2 * p] + t[2 * p + 1];
+    }
+  }
+
+  // Complexity: O(log n)
+  int64_t range_sum(int l, int r) const {
+    int64_t sum = 0;
+    for (int lo = l - 1 + size, hi = r + size; lo < hi; lo >>= 1, hi >>= 1) {
+      if (lo & 1) {
+        sum += t[lo++];
+      }
+      if (hi & 1) {
+        sum += t[--hi];
+      }
+    }
+    return sum;
+  }
+  // Complexity: O(log n)
+  int64_t prefix_sum(int idx) const { return range_sum(1, idx); }
+  // Adds delta to a[idx].
+  // Complexity: O(log n)
+  void update(int idx, int64_t delta) {
+    for (int p = idx - 1 + size; p >= 1; p >>= 1) {
+      t[p] += delta;
+    }
+  }
+
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(*this) + t.capacity() * sizeof(int64_t);
+  }
+
+  int n;
+  // Number of leaves, a power of two.
+  int size;
+  std::vector<int64_t> t;
+};
+
+// Sqrt decomposition: the array split into blocks of ~sqrt(n) elements, with
+// the sum of each block kept aside.
+struct SqrtBlocks {
+  explicit SqrtBlocks(int m)
+      : n((1 << m) - 1),
+        shift((m + 1) / 2),
+        a(n + 1, 0LL),
+        blocks((n >> shift) + 1, 0LL) {}
+
+  // Replaces the array with a[1..n].
+  // Complexity: O(n)
+  void construct(const int64_t* values) {
+    std::copy(values + 1, values + n + 1, a.begin() + 1);
+    std::fill(blocks.begin(), blocks.end(), 0LL);
+    for (int i = 1; i <= n; i++) {
+      blocks[i >> shift] += a[i];
+    }
+  }
+
+  // Complexity: O(sqrt n)
+  int64_t prefix_sum(int idx) const {
+    int64_t sum = 0;
+    int block = idx >> shift;
+    for (int b = 0; b < block; b++) {
+      sum += blocks[b];
+    }
+    for (int i = block << shift; i <= idx; i++) {
+      sum += a[i];
+    }
+    return sum;
+  }
+  // Complexity: O(sqrt n)
+  int64_t range_sum(int l, int r) const {
+    return prefix_sum(r) - prefix_sum(l - 1);
+  }
+  // Adds delta to a[idx].
+  // Complexity: O(1)
+  void update(int idx, int64_t delta) {
+    a[idx] += delta;
+    blocks[idx >> shift] += delta;
+  }
+
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(*this) +
+           (a.capacity() + blocks.capacity()) * sizeof(int64_t);
+  }
+
+  int n;
+  // Element i belongs to the block i >> shift.
+  int shift;
+  std::vector<int64_t> a;
+  std::vector<int64_t> blocks;
+};
+
+// Static range minimum: table[k][i] = min(a[i], ..., a[i + 2^k - 1]).
+// Takes O(n log n) memory.
+struct SparseTable {
+  static constexpr bool kDynamic = false;
+
+  explicit SparseTable(int n) : n(n) {}
+
+  // Complexity: O(n log n)
+  void construct(const int* a) {
+    table.assign(1, std::vector<int>(a, a + n + 1));
+    for (int k = 1; (1 << k) <= n; k++) {
+      const std::vector<int>& prev = table[k - 1];
+      std::vector<int> level(n + 1, INT_MAX);
+      for (int i = 1; i + (1 << k) - 1 <= n; i++) {
+        level[i] = std::min(prev[i], prev[i + (1 << (k - 1))]);
+      }
+      table.push_back(std::move(level));
+    }
+  }
+  // Complexity: O(1)
+  int query(int from, int to) const {
+    int k = 31 - __builtin_clz(to - from + 1);
+    return std::min(table[k][from], table[k][to - (1 << k) + 1]);
+  }
+
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    size_t bytes = sizeof(*this) + table.capacity() * sizeof(std::vector<int>);
+    for (const auto& level : table) {
+      bytes += level.capacity() * sizeof(int);
+    }
+    return bytes;
+  }
+
+  int n;
+  std::vector<std::vector<int>> table;
+};
+
+// Iterative segment tree for range minimum, laid out like SegmentTree.
+struct MinSegmentTree {
+  static constexpr bool kDynamic = true;
+
+  explicit MinSegmentTree(int n) : n(n), size(1) {
+    while (size < n) {
+      size <<= 1;
+    }
+    t.assign(2 * size, INT_MAX);
+  }
+
+  // Complexity: O(n)
+  void construct(const int* a) {
+    std::copy(a + 1, a + n + 1, t.begin() + size);
+    for (int p = size - 1; p >= 1; p--) {
+      t[p] = std::min(t[2 * p], t[2 * p + 1]);
+    }
+  }
+  // Complexity: O(log n)
+  int query(int from, int to) const {
+    int res = INT_MAX;
+    for (int lo = from - 1 + size, hi = to + size; lo < hi;
+         lo >>= 1, hi >>= 1) {
+      if (lo & 1) {
+        res = std::min(res, t[lo++]);
+      }
+      if (hi & 1) {
+        res = std::min(res, t[--hi]);
+      }
+    }
+    return res;
+  }
+  // Sets a[idx] to val.
+  // Complexity: O(log n)
+  void update(int idx, int val) {
+    int p = idx - 1 + size;
+    t[p] = val;
+    for (p >>= 1; p >= 1; p >>= 1) {
+      t[p] = std::min(t[2 * p], t[2 * p + 1]);
+    }
+  }
+
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(*this) + t.capacity() * sizeof(int);
+  }
+
+  int n;
+  // Number of leaves, a power of two.
+  int size;
+  std::vector<int> t;
+};
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_BASELINES_H_
@@ -0,0 +1,94 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_BYTES_H_
+#define BENCHMARK_BYTES_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "absl/strings/substitute.h"
+#include "absl/time/time.h"
+
+namespace fenwick {
+namespace bench {
+
+// Models of the memory an operation touches, for reporting bytes per operation
+// and the achieved bandwidth. They count the nodes the index walks visit, each
+// visit once whether it reads or writes, so they describe the traffic the
+// operation asks of the caches, not what reaches DRAM.
+//
+// Counting outside of the structures keeps their loops untouched: the models
+// run over the same inputs as the measured loop, but untimed.
+
+// Nodes visited by the walk idx, idx - lowbit(idx), ..., > 0, the one of
+// prefix_sum.
+inline int down_walk(int idx) { return __builtin_popcount(idx); }
+
+// Nodes visited by the walk idx, idx + lowbit(idx), ..., <= n, the one of
+// update.
+inline int up_walk(int idx, int n) {
+  int nodes = 0;
+  for (; idx <= n; idx += idx & -idx) {
+    nodes++;
+  }
+  return nodes;
+}
+
+// Returns the achieved bandwidth in GB/s: bytes per nanosecond.
+inline double gb_per_sec(double bytes_per_op, double ns_per_op) {
+  return ns_per_op > 0 ? bytes_per_op / ns_per_op : 0;
+}
+
+// Prints the bytes per operation and the bandwidth they amount to over the
+// mean duration of an operation. Prints nothing unless enabled, two tab
+// separated columns if plot.
+inline void print_bytes(double bytes, absl::Duration duration, bool enabled,
+                        bool plot) {
+  if (!enabled) {
+    return;
+  }
+  double gbps = gb_per_sec(bytes, absl::ToDoubleNanoseconds(duration));
+  if (!plot) {
+    auto msg = absl::Substitute("bytes/op: $0 GB/s: $1", bytes, gbps);
+    printf("    %s\n", msg.c_str());
+  } else {
+    printf("%15.3lf\t%15.3lf\t", bytes, gbps);
+  }
+}
+
+// Prints the memory footprint of a structure. Prints nothing unless enabled, a
+// tab separated column if plot.
+inline void print_memory(size_t bytes, bool enabled, bool plot) {
+  if (!enabled) {
+    return;
+  }
+  if (!plot) {
+    printf("  memory_bytes: %zu\n", bytes);
+  } else {
+    printf("%15zu\t", bytes);
+  }
+}
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_BYTES_H_
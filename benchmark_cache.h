@@ -0,0 +1,166 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_CACHE_H_
+#define BENCHMARK_CACHE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "benchmark_latency.h"
+
+namespace fenwick {
+namespace bench {
+
+// Cold and warm cache measurements. The mean loops of the benchmarks run the
+// operations back to back, so at the small orders the structure sits in the
+// caches for all of them. Here every operation is timed on its own, either
+// right after the caches were flushed (cold, the first touch after other
+// work evicted the structure) or after the structure was read in whole
+// (warm).
+
+// The cold numbers assume that streaming through the flush buffer evicts the
+// whole structure from the last level cache (LLC). The buffer is
+// kFlushLLCMultiple times the LLC, as last_level_cache_bytes() finds it,
+// several times so that adaptive replacement policies, which keep some of the
+// older lines, evict them too. It is at least kMinFlushBytes. Where the LLC
+// size is unknown, that minimum only covers an LLC well below 64 MiB, while
+// many servers have 96 MiB or more.
+constexpr size_t kFlushLLCMultiple = 4;
+constexpr size_t kMinFlushBytes = 64 << 20;
+constexpr size_t kCacheLine = 64;
+
+// Returns the size of the largest cache of the first CPU in bytes, read from
+// sysfs, or from sysconf if that fails. Returns 0 if both fail.
+inline size_t last_level_cache_bytes() {
+  size_t largest = 0;
+#ifdef __linux__
+  for (int index = 0; index < 16; index++) {
+    std::string path = "/sys/devices/system/cpu/cpu0/cache/index" +
+                       std::to_string(index) + "/size";
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+      break;
+    }
+    size_t size;
+    char unit = '\0';
+    if (fscanf(file, "%zu%c", &size, &unit) >= 1) {
+      if (unit == 'K') {
+        size <<= 10;
+      } else if (unit == 'M') {
+        size <<= 20;
+      } else if (unit == 'G') {
+        size <<= 30;
+      }
+      largest = std::max(largest, size);
+    }
+    fclose(file);
+  }
+#ifdef _SC_LEVEL3_CACHE_SIZE
+  if (largest == 0) {
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    largest = size > 0 ? size : 0;
+  }
+#endif
+#endif
+  return largest;
+}
+
+// Returns the size of the flush buffer, see kFlushLLCMultiple.
+inline size_t flush_bytes() {
+  return std::max(kMinFlushBytes, kFlushLLCMultiple * last_level_cache_bytes());
+}
+
+// Evicts the caches by streaming through a buffer larger than them. Writing
+// every line also pushes the structure's dirty lines out.
+struct CacheFlusher {
+  explicit CacheFlusher(size_t bytes) : buffer(bytes, 0) {}
+
+  void flush() {
+    for (size_t i = 0; i < buffer.size(); i += kCacheLine) {
+      buffer[i]++;
+    }
+    keep(buffer[0]);
+  }
+
+  std::vector<uint8_t> buffer;
+};
+
+// The flusher shared by all the measurements of the program, allocating the
+// buffer once.
+inline CacheFlusher* default_flusher() {
+  static CacheFlusher flusher(flush_bytes());
+  return &flusher;
+}
+
+// Reads a byte of every cache line of [data, data + bytes).
+inline void touch(const void* data, size_t bytes) {
+  const volatile uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < bytes; i += kCacheLine) {
+    p[i];
+  }
+}
+
+// Latencies of the same operations timed warm and cold.
+struct CacheSamples {
+  LatencyHistogram warm;
+  LatencyHistogram cold;
+};
+
+// Times op(0), ..., op(count - 1) one by one, count = min(ntc, max_count),
+// twice: first after warm() brought the structure in (warm), then each right
+// after a flush (cold). Operations that modify the structure get applied
+// twice.
+template <typename Warm, typename Op>
+void sample_cache_modes(int ntc, int max_count, Warm warm,
+                        CacheSamples* samples, Op op) {
+  using Void = std::is_void<decltype(op(0))>;
+  int count = std::min(ntc, max_count);
+  uint64_t overhead = timer_overhead();
+  CacheFlusher* flusher = default_flusher();
+  warm();
+  for (int tc = 0; tc < count; tc++) {
+    uint64_t start = ticks();
+    call(op, tc, Void());
+    uint64_t elapsed = ticks() - start;
+    samples->warm.record(elapsed > overhead ? elapsed - overhead : 0);
+  }
+  for (int tc = 0; tc < count; tc++) {
+    flusher->flush();
+    uint64_t start = ticks();
+    call(op, tc, Void());
+    uint64_t elapsed = ticks() - start;
+    samples->cold.record(elapsed > overhead ? elapsed - overhead : 0);
+  }
+}
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_CACHE_H_
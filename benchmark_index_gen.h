@@ -0,0 +1,284 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_INDEX_GEN_H_
+#define BENCHMARK_INDEX_GEN_H_
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+
+namespace fenwick {
+namespace bench {
+
+// Samples k in [1, n] with probability proportional to 1 / k^s, in O(1)
+// expected time and memory, by rejection-inversion (Hormann and Derflinger,
+// "Rejection-inversion to generate variates from monotone discrete
+// distributions", 1996).
+class ZipfDistribution {
+ public:
+  // Assumes that: n >= 1 and s > 0.
+  ZipfDistribution(int n, double s)
+      : n_(n),
+        s_(s),
+        h_x1_(big_h(1.5) - 1.0),
+        h_n_(big_h(n + 0.5)),
+        cut_(2.0 - big_h_inverse(big_h(2.5) - h(2.0))) {}
+
+  template <typename Prng>
+  int operator()(Prng& prng) {
+    std::uniform_real_distribution<double> unif(0.0, 1.0);
+    while (true) {
+      double u = h_n_ + unif(prng) * (h_x1_ - h_n_);
+      double x = big_h_inverse(u);
+      int k = static_cast<int>(x + 0.5);
+      if (k < 1) {
+        k = 1;
+      } else if (k > n_) {
+        k = n_;
+      }
+      if (k - x <= cut_ || u >= big_h(k + 0.5) - h(k)) {
+        return k;
+      }
+    }
+  }
+
+ private:
+  // h(x) = 1 / x^s, the density.
+  double h(double x) const { return std::exp(-s_ * std::log(x)); }
+  // H(x), an antiderivative of h, (x^(1 - s) - 1) / (1 - s), continuous at
+  // s = 1.
+  double big_h(double x) const {
+    double log_x = std::log(x);
+    return expm1_over((1.0 - s_) * log_x) * log_x;
+  }
+  // The inverse of H.
+  double big_h_inverse(double x) const {
+    double t = x * (1.0 - s_);
+    if (t < -1.0) {
+      t = -1.0;
+    }
+    return std::exp(log1p_over(t) * x);
+  }
+  // log(1 + x) / x, and its limit at 0.
+  static double log1p_over(double x) {
+    if (std::abs(x) > 1e-8) {
+      return std::log1p(x) / x;
+    }
+    return 1.0 - x * (0.5 - x / 3.0);
+  }
+  // (exp(x) - 1) / x, and its limit at 0.
+  static double expm1_over(double x) {
+    if (std::abs(x) > 1e-8) {
+      return std::expm1(x) / x;
+    }
+    return 1.0 + x * (0.5 + x / 6.0);
+  }
+
+  int n_;
+  double s_;
+  double h_x1_;
+  double h_n_;
+  double cut_;
+};
+
+// Maps [0, n) onto itself, scattering consecutive values, so that hot ranks
+// do not all land next to each other (or at the cheap small indexes).
+// Multiplying by an odd number permutes [0, 2^k), values that fall outside
+// [0, n) are mapped again until they fall in (cycle walking).
+class Scatter {
+ public:
+  explicit Scatter(int n) : n_(n), mask_(1) {
+    while (mask_ < static_cast<uint64_t>(n)) {
+      mask_ <<= 1;
+    }
+    mask_--;
+  }
+
+  int operator()(int x) const {
+    uint64_t y = x;
+    do {
+      y = (y * kMultiplier + kIncrement) & mask_;
+    } while (y >= static_cast<uint64_t>(n_));
+    return y;
+  }
+
+ private:
+  static constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15ULL;
+  static constexpr uint64_t kIncrement = 0x632BE59BD9B4E019ULL;
+
+  int n_;
+  uint64_t mask_;
+};
+
+// An access pattern over the indexes [1, n] of a benchmarked structure, given
+// as "name" or "name:param":
+//   uniform          every index equally likely (the default)
+//   zipf[:s]         Zipf with exponent s (default 0.99), ranks scattered
+//   sequential       1, 2, ..., n, 1, 2, ...
+//   strided[:k]      1, 1 + k, 1 + 2k, ... modulo n, k a positive integer
+//                    (default 4096)
+//   hotset[:f]       90% of the accesses go to a scattered fraction f of the
+//                    indexes (default 0.01), the rest to the others
+//   bursty[:b]       bursts of b (a positive integer, default 64) accesses
+//                    within 1024 indexes of a random center, then a jump to a
+//                    new center
+struct IndexPattern {
+  enum Kind { kUniform, kZipf, kSequential, kStrided, kHotSet, kBursty };
+
+  // Usage line for command line help.
+  static constexpr const char* kUsage =
+      "uniform|zipf[:s]|sequential|strided[:k]|hotset[:f]|bursty[:b]";
+
+  // Parses spec into pattern. Returns false if spec is malformed.
+  static bool parse(const std::string& spec, IndexPattern* pattern) {
+    std::string name = spec.substr(0, spec.find(':'));
+    bool has_param = name.size() < spec.size();
+    double param = 0.0;
+    if (has_param) {
+      const char* begin = spec.c_str() + name.size() + 1;
+      char* end;
+      param = strtod(begin, &end);
+      if (end == begin || *end != '\0' || !(param > 0.0)) {
+        return false;
+      }
+    }
+    struct Entry {
+      const char* name;
+      Kind kind;
+      double default_param;
+    };
+    static const Entry kEntries[] = {
+        {"uniform", kUniform, 0.0},     {"zipf", kZipf, 0.99},
+        {"sequential", kSequential, 0.0}, {"strided", kStrided, 4096},
+        {"hotset", kHotSet, 0.01},      {"bursty", kBursty, 64},
+    };
+    for (const Entry& entry : kEntries) {
+      if (name != entry.name) {
+        continue;
+      }
+      if (has_param && entry.default_param == 0.0) {
+        return false;
+      }
+      if (entry.kind == kHotSet && param >= 1.0) {
+        return false;
+      }
+      // Strides and burst lengths are counts, a fraction would truncate to 0.
+      if ((entry.kind == kStrided || entry.kind == kBursty) && has_param &&
+          (param != std::floor(param) || param > INT_MAX)) {
+        return false;
+      }
+      pattern->kind = entry.kind;
+      pattern->param = has_param ? param : entry.default_param;
+      return true;
+    }
+    return false;
+  }
+
+  // Parses the --pattern=<spec> flag out of the command line. Returns false on
+  // an unknown argument or a malformed spec.
+  static bool from_args(int argc, char** argv, IndexPattern* pattern) {
+    static const char kFlag[] = "--pattern=";
+    for (int i = 1; i < argc; i++) {
+      if (strncmp(argv[i], kFlag, sizeof(kFlag) - 1) != 0 ||
+          !parse(argv[i] + sizeof(kFlag) - 1, pattern)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Returns a generator of indexes in [1, n] following this pattern. The
+  // generator keeps a reference to prng.
+  std::function<int()> make(int n, std::mt19937* prng) const {
+    switch (kind) {
+      case kUniform:
+        break;
+      case kZipf: {
+        ZipfDistribution zipf(n, param);
+        Scatter scatter(n);
+        return [=]() mutable { return scatter(zipf(*prng) - 1) + 1; };
+      }
+      case kSequential: {
+        int i = 0;
+        return [=]() mutable {
+          i = i % n + 1;
+          return i;
+        };
+      }
+      case kStrided: {
+        int64_t stride = static_cast<int64_t>(param) % n;
+        int64_t i = n - stride;
+        return [=]() mutable {
+          i = (i + stride) % n;
+          return static_cast<int>(i) + 1;
+        };
+      }
+      case kHotSet: {
+        int hot = std::max(1, static_cast<int>(n * param));
+        Scatter scatter(n);
+        std::bernoulli_distribution is_hot(0.9);
+        std::uniform_int_distribution<int> hot_dist(0, hot - 1);
+        std::uniform_int_distribution<int> cold_dist(std::min(hot, n - 1),
+                                                     n - 1);
+        return [=]() mutable {
+          int rank = is_hot(*prng) ? hot_dist(*prng) : cold_dist(*prng);
+          return scatter(rank) + 1;
+        };
+      }
+      case kBursty: {
+        constexpr int kRadius = 1024;
+        int burst = static_cast<int>(param);
+        int left = 0;
+        int lo = 1;
+        int hi = n;
+        std::uniform_int_distribution<int> center_dist(1, n);
+        std::uniform_int_distribution<int> idx_dist;
+        return [=]() mutable {
+          if (left == 0) {
+            int center = center_dist(*prng);
+            lo = std::max(1, center - kRadius);
+            hi = std::min(n, center + kRadius);
+            left = burst;
+          }
+          left--;
+          return idx_dist(*prng, decltype(idx_dist)::param_type(lo, hi));
+        };
+      }
+    }
+    std::uniform_int_distribution<int> dist(1, n);
+    return [=]() mutable { return dist(*prng); };
+  }
+
+  Kind kind = kUniform;
+  // The optional parameter, see above.
+  double param = 0.0;
+};
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_INDEX_GEN_H_
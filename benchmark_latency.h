@@ -0,0 +1,220 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_LATENCY_H_
+#define BENCHMARK_LATENCY_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace fenwick {
+namespace bench {
+
+// Returns a timestamp in ticks: the TSC on x86, steady_clock nanoseconds
+// elsewhere. The fences keep the timed code from leaking out of the interval.
+inline uint64_t ticks() {
+  asm volatile("" : : : "memory");
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_lfence();
+  uint64_t t = __rdtsc();
+  _mm_lfence();
+#else
+  uint64_t t = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+                   .count();
+#endif
+  asm volatile("" : : : "memory");
+  return t;
+}
+
+// Keeps the compiler from dropping the computation of value.
+template <typename T>
+inline void keep(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Returns the length of a tick in nanoseconds, calibrated once against
+// steady_clock.
+inline double ns_per_tick() {
+#if defined(__x86_64__) || defined(__i386__)
+  static const double kNsPerTick = []() {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    uint64_t start_ticks = ticks();
+    while (Clock::now() - start < std::chrono::milliseconds(20)) {
+    }
+    uint64_t end_ticks = ticks();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start)
+                    .count();
+    return ns / (end_ticks - start_ticks);
+  }();
+  return kNsPerTick;
+#else
+  return 1.0;
+#endif
+}
+
+// Returns the cost of timing an empty interval, in ticks. It's subtracted from
+// every recorded latency.
+inline uint64_t timer_overhead() {
+  static const uint64_t kOverhead = []() {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 1000; i++) {
+      uint64_t start = ticks();
+      uint64_t elapsed = ticks() - start;
+      if (elapsed < best) {
+        best = elapsed;
+      }
+    }
+    return best;
+  }();
+  return kOverhead;
+}
+
+// Log-linear histogram of latencies. Every power of two is split into
+// 2^kSubBits equal buckets, so a reported percentile is within ~3% of the
+// true value, and the memory does not depend on the number of samples.
+struct LatencyHistogram {
+  static constexpr int kSubBits = 5;
+  static constexpr int kSub = 1 << kSubBits;
+
+  LatencyHistogram()
+      : counts((64 - kSubBits + 1) * kSub, 0), count(0), total(0) {}
+
+  // Records a latency of t ticks.
+  void record(uint64_t t) {
+    counts[bucket(t)]++;
+    count++;
+    total += t;
+  }
+
+  // Returns the mean of the recorded latencies in nanoseconds, exact unlike
+  // the percentiles.
+  double mean() const {
+    return count == 0 ? 0.0 : 1.0 * total / count * ns_per_tick();
+  }
+
+  // Returns the q-quantile of the recorded latencies in nanoseconds, e.g.
+  // q = 0.99 for p99.
+  // Assumes that: 0 < q <= 1.
+  double percentile(double q) const {
+    if (count == 0) {
+      return 0.0;
+    }
+    int64_t rank = static_cast<int64_t>(q * count + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    }
+    int64_t seen = 0;
+    for (int b = 0; b < static_cast<int>(counts.size()); b++) {
+      seen += counts[b];
+      if (seen >= rank) {
+        return midpoint(b) * ns_per_tick();
+      }
+    }
+    return midpoint(counts.size() - 1) * ns_per_tick();
+  }
+
+  // Adds all the latencies recorded in other.
+  void merge(const LatencyHistogram& other) {
+    for (size_t b = 0; b < counts.size(); b++) {
+      counts[b] += other.counts[b];
+    }
+    count += other.count;
+    total += other.total;
+  }
+
+  // Forgets all the recorded latencies.
+  void clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    count = 0;
+    total = 0;
+  }
+
+  // Number of latencies in each bucket.
+  std::vector<int64_t> counts;
+  // Number of recorded latencies.
+  int64_t count;
+  // Sum of the recorded latencies in ticks.
+  uint64_t total;
+
+ private:
+  // Values below kSub get a bucket each. Above, value v with the highest bit
+  // e is in bucket (e - kSubBits + 1) * kSub + (the next kSubBits bits of v).
+  static int bucket(uint64_t v) {
+    if (v < kSub) {
+      return v;
+    }
+    int e = 63 - __builtin_clzll(v);
+    int shift = e - kSubBits;
+    return ((shift + 1) << kSubBits) + ((v >> shift) & (kSub - 1));
+  }
+
+  // Returns the middle of the range of values of bucket b.
+  static double midpoint(int b) {
+    if (b < kSub) {
+      return b;
+    }
+    int shift = (b >> kSubBits) - 1;
+    uint64_t lo = static_cast<uint64_t>(kSub + (b & (kSub - 1))) << shift;
+    return lo + ((1ULL << shift) - 1) / 2.0;
+  }
+};
+
+// Calls op(tc), keeping the result if there is one.
+template <typename Op>
+inline void call(Op& op, int tc, std::true_type /* returns void */) {
+  op(tc);
+}
+template <typename Op>
+inline void call(Op& op, int tc, std::false_type /* returns void */) {
+  keep(op(tc));
+}
+
+// Calls op(0), ..., op(ntc - 1) and records the latency of every period-th
+// call in hist. The calls in between run untimed, so the timed ones see the
+// caches as the other calls left them.
+template <typename Op>
+void sample_latencies(int ntc, int period, LatencyHistogram* hist, Op op) {
+  using Void = std::is_void<decltype(op(0))>;
+  uint64_t overhead = timer_overhead();
+  for (int tc = 0; tc < ntc; tc++) {
+    if (tc % period != 0) {
+      call(op, tc, Void());
+      continue;
+    }
+    uint64_t start = ticks();
+    call(op, tc, Void());
+    uint64_t elapsed = ticks() - start;
+    hist->record(elapsed > overhead ? elapsed - overhead : 0);
+  }
+}
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_LATENCY_H_
@@ -0,0 +1,219 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_PERF_H_
+#define BENCHMARK_PERF_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "absl/strings/substitute.h"
+
+namespace fenwick {
+namespace bench {
+
+// Hardware performance counters of the calling thread, read through
+// perf_event_open(2). Counters the kernel or the CPU does not provide (e.g. in
+// most VMs, or with a high perf_event_paranoid) read as -1, the rest still
+// work. Everywhere except Linux, all of them read as -1.
+struct PerfCounters {
+  enum Event {
+    kCycles,
+    kInstructions,
+    kL1DMisses,
+    kLLCMisses,
+    kDTLBMisses,
+    kBranchMisses,
+    kNumEvents,
+  };
+
+  // Returns a short name of the event, for reports.
+  static const char* name(int event) {
+    static const char* const kNames[kNumEvents] = {
+        "cycles",      "instructions", "l1d_misses",
+        "llc_misses",  "dtlb_misses",  "branch_misses",
+    };
+    return kNames[event];
+  }
+
+  // Opens the counters if enabled, otherwise all of them read as -1.
+  explicit PerfCounters(bool enabled) {
+    for (int e = 0; e < kNumEvents; e++) {
+      fds[e] = enabled ? open_event(e) : -1;
+      values[e] = -1;
+    }
+  }
+
+  // Disable copying and assigning.
+  PerfCounters(const PerfCounters&) = delete;
+  void operator=(const PerfCounters&) = delete;
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  // Resets and starts counting.
+  void start() {
+#ifdef __linux__
+    for (int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  // Stops counting and stores the counts since start() into values. Counts of
+  // multiplexed events are scaled up to the whole interval.
+  void stop() {
+#ifdef __linux__
+    for (int e = kNumEvents - 1; e >= 0; e--) {
+      if (fds[e] >= 0) {
+        ioctl(fds[e], PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+    for (int e = 0; e < kNumEvents; e++) {
+      // value, time enabled, time running
+      uint64_t buf[3];
+      if (fds[e] < 0 || read(fds[e], buf, sizeof(buf)) != sizeof(buf)) {
+        values[e] = -1;
+      } else if (buf[2] == 0) {
+        values[e] = 0;
+      } else {
+        values[e] = static_cast<int64_t>(
+            static_cast<double>(buf[0]) * buf[1] / buf[2]);
+      }
+    }
+#endif
+  }
+
+  // Whether at least one counter is available.
+  bool available() const {
+    for (int fd : fds) {
+      if (fd >= 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // File descriptors of the counters, -1 if not available.
+  int fds[kNumEvents];
+  // Counts of the last start() / stop() interval, -1 if not available.
+  int64_t values[kNumEvents];
+
+ private:
+  // Opens a disabled, user-space-only counter for the calling thread. Returns
+  // the file descriptor or -1.
+  static int open_event(int event) {
+#ifdef __linux__
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    switch (event) {
+      case kCycles:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        break;
+      case kInstructions:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        break;
+      case kL1DMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache_event(PERF_COUNT_HW_CACHE_L1D);
+        break;
+      case kLLCMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache_event(PERF_COUNT_HW_CACHE_LL);
+        break;
+      case kDTLBMisses:
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache_event(PERF_COUNT_HW_CACHE_DTLB);
+        break;
+      case kBranchMisses:
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+        break;
+    }
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)event;
+    return -1;
+#endif
+  }
+
+#ifdef __linux__
+  // Config of the read-miss event of the given cache.
+  static uint64_t cache_event(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+#endif
+};
+
+// Prints the counts of the last interval per operation, ntc operations in
+// total, -1 for the counters that are not available. Prints nothing unless
+// enabled, tab separated columns if plot.
+inline void print_counters(const PerfCounters& perf, int ntc, bool enabled,
+                           bool plot) {
+  if (!enabled) {
+    return;
+  }
+  if (!plot) {
+    std::string msg;
+    for (int e = 0; e < PerfCounters::kNumEvents; e++) {
+      double value = perf.values[e] < 0 ? -1 : 1.0 * perf.values[e] / ntc;
+      msg += absl::Substitute("$0: $1 ", PerfCounters::name(e), value);
+    }
+    printf("    %s\n", msg.c_str());
+  } else {
+    for (int e = 0; e < PerfCounters::kNumEvents; e++) {
+      double value = perf.values[e] < 0 ? -1 : 1.0 * perf.values[e] / ntc;
+      printf("%15.3lf\t", value);
+    }
+  }
+}
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_PERF_H_
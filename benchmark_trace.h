@@ -0,0 +1,228 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_TRACE_H_
+#define BENCHMARK_TRACE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fenwick {
+namespace bench {
+
+// Binary traces of operations on the 1D structures, to benchmark recorded
+// workloads instead of the synthetic ones. A trace is a TraceHeader followed
+// by header.count TraceRecords, in the byte order of the recording host.
+//
+// The initial contents of the structure are not recorded. The replay fills it
+// with random values drawn from header.seed, the way the workloads of
+// benchmark_workload.h do, so a trace replays on the same values it was
+// generated against.
+
+constexpr char kTraceMagic[8] = "FWTRACE";
+
+struct TraceHeader {
+  static constexpr uint32_t kVersion = 1;
+
+  char magic[8];
+  uint32_t version;
+  // The structure has 2^order - 1 elements.
+  int32_t order;
+  // Seed of the initial values.
+  uint32_t seed;
+  uint32_t reserved;
+  // Number of records that follow.
+  uint64_t count;
+};
+static_assert(sizeof(TraceHeader) == 32, "TraceHeader must stay 32 bytes.");
+
+// One operation. The fields mean what they do in the structures' methods:
+//   update       per structure: a[a] += val on fenwick, prefix_array,
+//                segment_tree and sqrt_blocks, a[a..b] += val on rurq, and
+//                a[a] = val on rmq; point updates keep b == a
+//   prefix_sum   a[1] + ... + a[a]
+//   range_sum    a[a] + ... + a[b]
+//   fast_search  the smallest index with a prefix sum >= val
+//   query        the minimum of a[a..b]
+//   query_index  the index of the minimum of a[a..b]
+// The names match the operation names of benchmark_workload.h. As update adds
+// on some structures and assigns on others, a trace replayed on a structure of
+// the other kind runs the same indexes, but on different values than recorded.
+struct TraceRecord {
+  enum Kind {
+    kUpdate,
+    kPrefixSum,
+    kRangeSum,
+    kFastSearch,
+    kQuery,
+    kQueryIndex,
+    kNumKinds
+  };
+  static const char* kind_name(int kind) {
+    static const char* const kNames[] = {"update",      "prefix_sum",
+                                         "range_sum",   "fast_search",
+                                         "query",       "query_index"};
+    return kNames[kind];
+  }
+
+  // Returns whether the record is well formed for a structure of size n.
+  bool valid(int n) const {
+    if (kind >= kNumKinds) {
+      return false;
+    }
+    if (kind == kFastSearch) {
+      return true;
+    }
+    if (kind == kPrefixSum) {
+      return 1 <= a && a <= n;
+    }
+    return 1 <= a && a <= b && b <= n;
+  }
+
+  int64_t val;
+  int32_t a;
+  int32_t b;
+  uint32_t kind;
+  uint32_t reserved;
+};
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord must stay 24 bytes.");
+
+// Appends records to a trace file through stdio.
+struct TraceWriter {
+  TraceWriter() : file(nullptr) {}
+  TraceWriter(const TraceWriter&) = delete;
+  void operator=(const TraceWriter&) = delete;
+  ~TraceWriter() { close(); }
+
+  // Creates the file at path, writing a header with no records yet.
+  bool open(const char* path, int order, uint32_t seed) {
+    file = fopen(path, "wb");
+    if (file == nullptr) {
+      return false;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kTraceMagic, sizeof(header.magic));
+    header.version = TraceHeader::kVersion;
+    header.order = order;
+    header.seed = seed;
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+  }
+
+  bool append(int kind, int a, int b, int64_t val) {
+    TraceRecord record = {val, a, b, static_cast<uint32_t>(kind), 0};
+    header.count++;
+    return fwrite(&record, sizeof(record), 1, file) == 1;
+  }
+
+  // Writes the final record count into the header and closes the file.
+  bool close() {
+    if (file == nullptr) {
+      return true;
+    }
+    bool ok = fseek(file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = fclose(file) == 0 && ok;
+    file = nullptr;
+    return ok;
+  }
+
+  FILE* file;
+  TraceHeader header;
+};
+
+// A trace mapped read-only into memory. The pages are populated and advised
+// sequential upfront, so reading the records doesn't add I/O or page faults to
+// the timed replay.
+struct MappedTrace {
+  MappedTrace() : data(nullptr), size(0), header(nullptr), records(nullptr) {}
+  MappedTrace(const MappedTrace&) = delete;
+  void operator=(const MappedTrace&) = delete;
+  ~MappedTrace() {
+    if (data != nullptr) {
+      munmap(data, size);
+    }
+  }
+
+  // Maps the trace at path. Returns false, with a message in *error, if it
+  // can't be read or isn't a trace.
+  bool open(const char* path, const char** error) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      *error = "can't open the file";
+      return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(TraceHeader)) {
+      ::close(fd);
+      *error = "too short for a header";
+      return false;
+    }
+    size = st.st_size;
+    int flags = MAP_PRIVATE;
+    #ifdef MAP_POPULATE
+      flags |= MAP_POPULATE;
+    #endif
+    void* addr = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      *error = "mmap failed";
+      return false;
+    }
+    data = addr;
+    madvise(data, size, MADV_SEQUENTIAL);
+    header = static_cast<const TraceHeader*>(data);
+    records = reinterpret_cast<const TraceRecord*>(header + 1);
+    if (memcmp(header->magic, kTraceMagic, sizeof(header->magic)) !=
+        0) {
+      *error = "bad magic";
+      return false;
+    }
+    if (header->version != TraceHeader::kVersion) {
+      *error = "unsupported version";
+      return false;
+    }
+    if (header->order < 1 || header->order > 30) {
+      *error = "bad order";
+      return false;
+    }
+    if ((size - sizeof(TraceHeader)) / sizeof(TraceRecord) < header->count) {
+      *error = "truncated";
+      return false;
+    }
+    return true;
+  }
+
+  void* data;
+  size_t size;
+  const TraceHeader* header;
+  const TraceRecord* records;
+};
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_TRACE_H_
@@ -0,0 +1,473 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef BENCHMARK_WORKLOAD_H_
+#define BENCHMARK_WORKLOAD_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+
+#include "benchmark_baselines.h"
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "fenwick.h"
+#include "fenwick_rmq.h"
+#include "fenwick_rurq.h"
+
+namespace fenwick {
+namespace bench {
+
+// Mixed read/write workloads over the structures, and the command line
+// parsing, shared by the mixed, the scaling and the trace benchmarks.
+
+constexpr int64_t kMaxVal = 1000;
+constexpr int kRmqMaxVal = 1 << 30;
+
+// One operation of the mix, of one of the workload's kinds.
+struct Op {
+  int kind;
+  int a;
+  int b;
+  int64_t val;
+};
+
+// Returns a range [*l, *r] with both ends drawn from idx_gen.
+inline void gen_range(const std::function<int()>& idx_gen, int* l, int* r) {
+  *l = idx_gen();
+  *r = idx_gen();
+  if (*l > *r) {
+    std::swap(*l, *r);
+  }
+}
+
+// Every workload wraps a structure filled with random values and provides:
+//   kNumOps operations, the first kNumWrites of them writes
+//   kRangeUpdates, whether the update (kind 0) covers a range [a, b]
+//   kDefaultMix
+//   op_name(kind)
+//   gen(kind, idx_gen, prng), makes the arguments of an operation, a point
+//     update at a has b == a
+//   apply(op), runs it, returning something to keep the compiler honest
+struct FenwickWorkload {
+  static constexpr int kNumOps = 4;
+  static constexpr int kNumWrites = 1;
+  static constexpr bool kRangeUpdates = false;
+  static constexpr const char* kDefaultMix = "update:10,prefix_sum:90";
+  static const char* op_name(int kind) {
+    static const char* const kNames[] = {"update", "prefix_sum", "range_sum",
+                                         "fast_search"};
+    return kNames[kind];
+  }
+
+  FenwickWorkload(int order, std::mt19937* prng)
+      : ft(Fenwick::allocate(order)) {
+    std::uniform_int_distribution<int64_t> val_dist(0, kMaxVal);
+    std::vector<int64_t> a(ft->n + 1);
+    for (int i = 1; i <= ft->n; i++) {
+      a[i] = val_dist(*prng);
+    }
+    ft->fast_construct(a.data());
+    total = ft->prefix_sum(ft->n);
+  }
+
+  ~FenwickWorkload() { free(ft); }
+
+  int n() const { return ft->n; }
+
+  Op gen(int kind, const std::function<int()>& idx_gen,
+         std::mt19937* prng) const {
+    Op op = {kind, 0, 0, 0};
+    switch (kind) {
+      case 0:
+        op.a = op.b = idx_gen();
+        op.val = std::uniform_int_distribution<int64_t>(0, kMaxVal)(*prng);
+        break;
+      case 1:
+        op.a = idx_gen();
+        break;
+      case 2:
+        gen_range(idx_gen, &op.a, &op.b);
+        break;
+      case 3:
+        op.val = std::uniform_int_distribution<int64_t>(1, total)(*prng);
+        break;
+    }
+    return op;
+  }
+
+  int64_t apply(const Op& op) {
+    switch (op.kind) {
+      case 0:
+        ft->update(op.a, op.val);
+        return 0;
+      case 1:
+        return ft->prefix_sum(op.a);
+      case 2:
+        return ft->range_sum(op.a, op.b);
+      default:
+        return ft->fast_search(op.val);
+    }
+  }
+
+  Fenwick* ft;
+  // Sum of the initial array, the range of the searched values.
+  int64_t total;
+};
+
+struct RURQWorkload {
+  static constexpr int kNumOps = 4;
+  static constexpr int kNumWrites = 1;
+  static constexpr bool kRangeUpdates = true;
+  static constexpr const char* kDefaultMix = "update:10,range_sum:90";
+  static const char* op_name(int kind) {
+    static const char* const kNames[] = {"update", "prefix_sum", "range_sum",
+                                         "fast_search"};
+    return kNames[kind];
+  }
+
+  RURQWorkload(int order, std::mt19937* prng) : ft(order) {
+    std::uniform_int_distribution<int64_t> val_dist(0, kMaxVal);
+    std::vector<int64_t> a(ft.n + 1);
+    for (int i = 1; i <= ft.n; i++) {
+      a[i] = val_dist(*prng);
+    }
+    ft.construct(a.data());
+    total = ft.prefix_sum(ft.n);
+  }
+
+  int n() const { return ft.n; }
+
+  Op gen(int kind, const std::function<int()>& idx_gen,
+         std::mt19937* prng) const {
+    Op op = {kind, 0, 0, 0};
+    switch (kind) {
+      case 0:
+        gen_range(idx_gen, &op.a, &op.b);
+        op.val = std::uniform_int_distribution<int64_t>(0, kMaxVal)(*prng);
+        break;
+      case 1:
+        op.a = idx_gen();
+        break;
+      case 2:
+        gen_range(idx_gen, &op.a, &op.b);
+        break;
+      case 3:
+        op.val = std::uniform_int_distribution<int64_t>(1, total)(*prng);
+        break;
+    }
+    return op;
+  }
+
+  int64_t apply(const Op& op) {
+    switch (op.kind) {
+      case 0:
+        ft.update(op.a, op.b, op.val);
+        return 0;
+      case 1:
+        return ft.prefix_sum(op.a);
+      case 2:
+        return ft.range_sum(op.a, op.b);
+      default:
+        return ft.fast_search(op.val);
+    }
+  }
+
+  FenwickRURQ ft;
+  // Sum of the initial array, the range of the searched values.
+  int64_t total;
+};
+
+struct RMQWorkload {
+  static constexpr int kNumOps = 3;
+  static constexpr int kNumWrites = 1;
+  static constexpr bool kRangeUpdates = false;
+  static constexpr const char* kDefaultMix = "update:10,query:90";
+  static const char* op_name(int kind) {
+    static const char* const kNames[] = {"update", "query", "query_index"};
+    return kNames[kind];
+  }
+
+  RMQWorkload(int order, std::mt19937* prng) : rmq((1 << order) - 1) {
+    std::uniform_int_distribution<int> val_dist(0, kRmqMaxVal);
+    std::vector<int> a(rmq.n + 1);
+    for (int i = 1; i <= rmq.n; i++) {
+      a[i] = val_dist(*prng);
+    }
+    rmq.construct(a.data());
+  }
+
+  int n() const { return rmq.n; }
+
+  Op gen(int kind, const std::function<int()>& idx_gen,
+         std::mt19937* prng) const {
+    Op op = {kind, 0, 0, 0};
+    if (kind == 0) {
+      op.a = op.b = idx_gen();
+      op.val = std::uniform_int_distribution<int>(0, kRmqMaxVal)(*prng);
+    } else {
+      gen_range(idx_gen, &op.a, &op.b);
+    }
+    return op;
+  }
+
+  int64_t apply(const Op& op) {
+    switch (op.kind) {
+      case 0:
+        rmq.update(op.a, op.val);
+        return 0;
+      case 1:
+        return rmq.query(op.a, op.b);
+      default:
+        return rmq.query_index(op.a, op.b);
+    }
+  }
+
+  rmq::FenwickRMQ<> rmq;
+};
+
+// A reference structure from benchmark_baselines.h under the operations it
+// shares with FenwickWorkload, which keep their kinds.
+template <typename Tree>
+struct ReferenceWorkload {
+  static constexpr int kNumOps = 3;
+  static constexpr int kNumWrites = 1;
+  static constexpr bool kRangeUpdates = false;
+  static constexpr const char* kDefaultMix = "update:10,prefix_sum:90";
+  static const char* op_name(int kind) {
+    static const char* const kNames[] = {"update", "prefix_sum", "range_sum"};
+    return kNames[kind];
+  }
+
+  ReferenceWorkload(int order, std::mt19937* prng) : tree(order) {
+    std::uniform_int_distribution<int64_t> val_dist(0, kMaxVal);
+    std::vector<int64_t> a(tree.n + 1);
+    for (int i = 1; i <= tree.n; i++) {
+      a[i] = val_dist(*prng);
+    }
+    tree.construct(a.data());
+  }
+
+  int n() const { return tree.n; }
+
+  Op gen(int kind, const std::function<int()>& idx_gen,
+         std::mt19937* prng) const {
+    Op op = {kind, 0, 0, 0};
+    switch (kind) {
+      case 0:
+        op.a = op.b = idx_gen();
+        op.val = std::uniform_int_distribution<int64_t>(0, kMaxVal)(*prng);
+        break;
+      case 1:
+        op.a = idx_gen();
+        break;
+      case 2:
+        gen_range(idx_gen, &op.a, &op.b);
+        break;
+    }
+    return op;
+  }
+
+  int64_t apply(const Op& op) {
+    switch (op.kind) {
+      case 0:
+        tree.update(op.a, op.val);
+        return 0;
+      case 1:
+        return tree.prefix_sum(op.a);
+      default:
+        return tree.range_sum(op.a, op.b);
+    }
+  }
+
+  Tree tree;
+};
+
+// Matches arg against "--name=" and returns the value after it, or nullptr.
+inline const char* flag_value(const char* arg, const char* name) {
+  size_t len = strlen(name);
+  if (strncmp(arg, "--", 2) != 0 || strncmp(arg + 2, name, len) != 0 ||
+      arg[2 + len] != '=') {
+    return nullptr;
+  }
+  return arg + 3 + len;
+}
+
+// A "--name=value" flag of the command line and the field of a benchmark's
+// config it sets. Integers go through atoi / atoll, bools are nonzero integers
+// and patterns go through IndexPattern::parse.
+struct Flag {
+  Flag(const char* name, std::string* field)
+      : name(name), set([field](const char* value) {
+          *field = value;
+          return true;
+        }) {}
+  Flag(const char* name, int* field)
+      : name(name), set([field](const char* value) {
+          *field = atoi(value);
+          return true;
+        }) {}
+  Flag(const char* name, int64_t* field)
+      : name(name), set([field](const char* value) {
+          *field = atoll(value);
+          return true;
+        }) {}
+  Flag(const char* name, bool* field)
+      : name(name), set([field](const char* value) {
+          *field = atoi(value) != 0;
+          return true;
+        }) {}
+  Flag(const char* name, IndexPattern* field)
+      : name(name), set([field](const char* value) {
+          return IndexPattern::parse(value, field);
+        }) {}
+
+  const char* name;
+  // Stores the value into the field. Returns false if it is malformed.
+  std::function<bool(const char*)> set;
+};
+
+// Parses the command line against flags. Returns false on an unknown flag or a
+// malformed value.
+inline bool parse_flags(int argc, char** argv, const std::vector<Flag>& flags) {
+  for (int i = 1; i < argc; i++) {
+    auto it = flags.begin();
+    const char* value = nullptr;
+    while (it != flags.end() && !(value = flag_value(argv[i], it->name))) {
+      ++it;
+    }
+    if (it == flags.end() || !it->set(value)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses mix, "op:weight,op:weight,...", into weights indexed by Workload's
+// operation kinds. Returns false if it names an unknown operation or has no
+// positive weight.
+template <typename Workload>
+bool parse_mix(const std::string& mix, std::vector<double>* weights) {
+  weights->assign(Workload::kNumOps, 0.0);
+  double sum = 0.0;
+  size_t pos = 0;
+  while (pos < mix.size()) {
+    size_t end = mix.find(',', pos);
+    if (end == std::string::npos) {
+      end = mix.size();
+    }
+    std::string item = mix.substr(pos, end - pos);
+    size_t colon = item.find(':');
+    if (colon == std::string::npos) {
+      return false;
+    }
+    std::string name = item.substr(0, colon);
+    char* rest;
+    double weight = strtod(item.c_str() + colon + 1, &rest);
+    if (*rest != '\0' || weight < 0.0) {
+      return false;
+    }
+    int kind = 0;
+    while (kind < Workload::kNumOps && name != Workload::op_name(kind)) {
+      kind++;
+    }
+    if (kind == Workload::kNumOps) {
+      return false;
+    }
+    (*weights)[kind] += weight;
+    sum += weight;
+    pos = end + 1;
+  }
+  return sum > 0.0;
+}
+
+// Generates count operations of Workload, with kinds drawn by weights and
+// indexes by pattern.
+template <typename Workload>
+std::vector<Op> gen_ops(const Workload& workload,
+                        const std::vector<double>& weights,
+                        const IndexPattern& pattern, int64_t count,
+                        unsigned seed) {
+  std::mt19937 prng(seed);
+  auto idx_gen = pattern.make(workload.n(), &prng);
+  std::discrete_distribution<int> kind_dist(weights.begin(), weights.end());
+  std::vector<Op> ops;
+  ops.reserve(count);
+  for (int64_t i = 0; i < count; i++) {
+    ops.push_back(workload.gen(kind_dist(prng), idx_gen, &prng));
+  }
+  return ops;
+}
+
+// Applies ops to workload in batches of batch. If mu is given, each batch holds
+// it in reader mode if it only reads, and in writer mode otherwise. If hist is
+// given, every period-th batch is timed into it, lock acquisition included.
+// Returns a value to keep the compiler from dropping the reads.
+template <typename Workload>
+int64_t apply_ops(Workload* workload, const std::vector<Op>& ops, int batch,
+                  absl::Mutex* mu, LatencyHistogram* hist, int period) {
+  int64_t sink = 0;
+  int64_t size = ops.size();
+  uint64_t overhead = hist != nullptr ? timer_overhead() : 0;
+  for (int64_t i = 0, k = 0; i < size; i += batch, k++) {
+    int64_t end = std::min(size, i + batch);
+    bool timed = hist != nullptr && k % period == 0;
+    uint64_t start = timed ? ticks() : 0;
+    if (mu == nullptr) {
+      for (int64_t j = i; j < end; j++) {
+        sink += workload->apply(ops[j]);
+      }
+    } else {
+      bool writes = false;
+      for (int64_t j = i; j < end; j++) {
+        writes = writes || ops[j].kind < Workload::kNumWrites;
+      }
+      if (writes) {
+        absl::WriterMutexLock lock(mu);
+        for (int64_t j = i; j < end; j++) {
+          sink += workload->apply(ops[j]);
+        }
+      } else {
+        absl::ReaderMutexLock lock(mu);
+        for (int64_t j = i; j < end; j++) {
+          sink += workload->apply(ops[j]);
+        }
+      }
+    }
+    if (timed) {
+      uint64_t elapsed = ticks() - start;
+      hist->record(elapsed > overhead ? elapsed - overhead : 0);
+    }
+  }
+  return sink;
+}
+
+}  // namespace bench
+}  // namespace fenwick
+
+#endif  // BENCHMARK_WORKLOAD_H_
@@ -40,14 +40,22 @@ struct Fenwick {
   static Fenwick* allocate(int m) {
     int n = (1 << m) - 1;
     int nmask = 1 << (m - 1);
-    Fenwick* instance = reinterpret_cast<Fenwick*>(
-        malloc(sizeof(Fenwick) + (n + 1) * sizeof(int64_t)));
+    Fenwick* instance = reinterpret_cast<Fenwick*>(malloc(memory_bytes(m)));
     instance->nmask = nmask;
     instance->n = n;
     std::fill_n(instance->T, n + 1, 0LL);
     return instance;
   }
 
+  // Returns the number of bytes allocate(m) takes.
+  static size_t memory_bytes(int m) {
+    return sizeof(Fenwick) + (static_cast<size_t>(1) << m) * sizeof(int64_t);
+  }
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(Fenwick) + (static_cast<size_t>(n) + 1) * sizeof(int64_t);
+  }
+
   // Disable other creation, copying ans assigning.
   Fenwick() = delete;
   Fenwick(const Fenwick&) = delete;
@@ -33,16 +33,27 @@ namespace fenwick {
 struct Fenwick2D {
   // Allocates the structure of size n x n, n = 2^m - 1 and sets all the
   // elements to 0. This is the one true way of creating this struct.
-  // Delete with free(3).
+  // Delete with free(3). Takes memory_bytes(m), 4^m * 8 bytes, e.g. 8 GiB for
+  // m = 15.
   static Fenwick2D* allocate(int m) {
     int n = (1 << m) - 1;
-    Fenwick2D* instance = reinterpret_cast<Fenwick2D*>(
-        malloc(sizeof(Fenwick2D) + (n + 1) * (n + 1) * sizeof(int64_t)));
+    Fenwick2D* instance = reinterpret_cast<Fenwick2D*>(malloc(memory_bytes(m)));
     instance->n = n;
     std::fill_n(instance->T, (n + 1) * (n + 1), 0LL);
     return instance;
   }
 
+  // Returns the number of bytes allocate(m) takes.
+  static size_t memory_bytes(int m) {
+    return sizeof(Fenwick2D) +
+           (static_cast<size_t>(1) << (2 * m)) * sizeof(int64_t);
+  }
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(Fenwick2D) +
+           (static_cast<size_t>(n) + 1) * (n + 1) * sizeof(int64_t);
+  }
+
   // Disable other creation, copying ans assigning.
   Fenwick2D() = delete;
   Fenwick2D(const Fenwick2D&) = delete;
@@ -94,6 +105,55 @@ struct Fenwick2D {
     return sum;
   }
 
+  // Returns the smallest x, such that the range sum a[1:x][y1:y2] is GEQ than
+  // val on success. Returns n + 1 if the whole slice sum is smaller.
+  // Complexity: O(log^3 n)
+  // Assumes that: 1 <= y1 <= y2 <= n.
+  // Note: This only works if the cumulative sums are nondecreasing!
+  int search(int y1, int y2, int64_t val) const {
+    int lo = 1;
+    int hi = n + 1;
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (range_sum(1, y1, mid, y2) >= val) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+
+  // Returns the smallest x, such that the range sum a[1:x][y1:y2] is GEQ than
+  // val on success. Returns n + 1 if the whole slice sum is smaller.
+  // Complexity: O(log^2 n)
+  // Assumes that: 1 <= y1 <= y2 <= n.
+  // Note: This only works if the cumulative sums are nondecreasing!
+  int fast_search(int y1, int y2, int64_t val) const {
+    val--;
+    int x = 0;
+    // Descend over x like Fenwick::fast_search, where the value of an x node
+    // is the y1..y2 slice of it's column, read from the inner tree.
+    for (int mask = (n + 1) >> 1; mask != 0; mask >>= 1) {
+      int xx = x + mask;
+      if (xx > n) {
+        continue;
+      }
+      int64_t node = 0;
+      for (int yy = y2; yy >= 1; yy -= yy & -yy) {
+        node += T[(n + 1) * yy + xx];
+      }
+      for (int yy = y1 - 1; yy >= 1; yy -= yy & -yy) {
+        node -= T[(n + 1) * yy + xx];
+      }
+      if (node <= val) {
+        val -= node;
+        x = xx;
+      }
+    }
+    return x + 1;
+  }
+
   // Size of the tree and the fictive array a are n x n.
   int n;
   // The tree storage array.
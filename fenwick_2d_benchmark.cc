@@ -19,10 +19,12 @@
 // SOFTWARE.
 
 #include <algorithm>
+#include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
 #include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -30,16 +32,59 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
+#include "benchmark_bytes.h"
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "benchmark_perf.h"
 #include "fenwick_2d.h"
 
 using fenwick::Fenwick2D;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::PerfCounters;
+using fenwick::bench::down_walk;
+using fenwick::bench::print_bytes;
+using fenwick::bench::print_counters;
+using fenwick::bench::print_memory;
+using fenwick::bench::keep;
+using fenwick::bench::up_walk;
 
 ////////////////////////////////////////////////////////////////////////////////
 // MEASUREMENT METHODS
 ////////////////////////////////////////////////////////////////////////////////
 
+// #define VERIFY
+
+// Count hardware events (see benchmark_perf.h) around each measured loop and
+// report them per operation.
+// #define PERF_COUNTERS
+#ifdef PERF_COUNTERS
+  constexpr bool kPerfCounters = true;
+#else
+  constexpr bool kPerfCounters = false;
+#endif
+
+// Report the memory footprint of every order, and the bytes the operations
+// touch (see benchmark_bytes.h) together with the bandwidth that amounts to.
+// #define BYTES
+#ifdef BYTES
+  constexpr bool kBytes = true;
+#else
+  constexpr bool kBytes = false;
+#endif
+
+// Bytes prefix_sum(x, y) and update(x, y, ...) touch: the x walk times the y
+// walk.
+int64_t prefix_sum_bytes(int x, int y) {
+  return static_cast<int64_t>(down_walk(x)) * down_walk(y) * sizeof(int64_t);
+}
+int64_t update_bytes(const Fenwick2D& ft, int x, int y) {
+  return static_cast<int64_t>(up_walk(x, ft.n)) * up_walk(y, ft.n) *
+         sizeof(int64_t);
+}
+
 absl::Duration measure_prefix_sum(Fenwick2D* ft, int ntc,
-                                  std::function<int64_t()> idx_gen) {
+                                  std::function<int64_t()> idx_gen,
+                                  PerfCounters* perf, double* bytes) {
   // Generate ntc indexes to query.
   std::vector<int> xs;
   std::vector<int> ys;
@@ -48,16 +93,26 @@ absl::Duration measure_prefix_sum(Fenwick2D* ft, int ntc,
     ys.push_back(idx_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->prefix_sum(xs[tc], ys[tc]);
+    keep(ft->prefix_sum(xs[tc], ys[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += prefix_sum_bytes(xs[tc], ys[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_range_sum(Fenwick2D* ft, int ntc,
-                                 std::function<int()> idx_gen) {
+                                 std::function<int()> idx_gen,
+                                 PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> x1s;
   std::vector<int> x2s;
@@ -80,17 +135,31 @@ absl::Duration measure_range_sum(Fenwick2D* ft, int ntc,
     y2s.push_back(y2);
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->range_sum(x1s[tc], y1s[tc], x2s[tc], y2s[tc]);
+    keep(ft->range_sum(x1s[tc], y1s[tc], x2s[tc], y2s[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    // The four corners, the empty ones walk nothing.
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += prefix_sum_bytes(x2s[tc], y2s[tc]) +
+               prefix_sum_bytes(x1s[tc] - 1, y2s[tc]) +
+               prefix_sum_bytes(x2s[tc], y1s[tc] - 1) +
+               prefix_sum_bytes(x1s[tc] - 1, y1s[tc] - 1);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_update(Fenwick2D* ft, int ntc,
                               std::function<int()> idx_gen,
-                              std::function<int()> val_gen) {
+                              std::function<int()> val_gen,
+                              PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> xs;
   std::vector<int> ys;
@@ -101,11 +170,83 @@ absl::Duration measure_update(Fenwick2D* ft, int ntc,
     vals.push_back(val_gen());
   }
   // Do the updates.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     ft->update(xs[tc], ys[tc], vals[tc]);
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += update_bytes(*ft, xs[tc], ys[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
+  return duration / ntc;
+}
+
+absl::Duration measure_search(Fenwick2D* ft, int ntc,
+                              std::function<int()> idx_gen,
+                              std::function<int64_t()> search_gen,
+                              PerfCounters* perf) {
+  // Generate ntc slices and values to search for.
+  std::vector<int> y1s;
+  std::vector<int> y2s;
+  std::vector<int64_t> vals;
+  for (int i = 0; i < ntc; i++) {
+    int y1 = idx_gen();
+    int y2 = idx_gen();
+    if (y1 > y2) {
+      std::swap(y1, y2);
+    }
+    y1s.push_back(y1);
+    y2s.push_back(y2);
+    vals.push_back(search_gen());
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    #ifndef VERIFY
+      keep(ft->search(y1s[tc], y2s[tc], vals[tc]));
+    #else
+      assert(ft->search(y1s[tc], y2s[tc], vals[tc]) ==
+             ft->fast_search(y1s[tc], y2s[tc], vals[tc]));
+    #endif
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
+  return duration / ntc;
+}
+
+absl::Duration measure_fast_search(Fenwick2D* ft, int ntc,
+                                   std::function<int()> idx_gen,
+                                   std::function<int64_t()> search_gen,
+                                   PerfCounters* perf) {
+  // Generate ntc slices and values to search for.
+  std::vector<int> y1s;
+  std::vector<int> y2s;
+  std::vector<int64_t> vals;
+  for (int i = 0; i < ntc; i++) {
+    int y1 = idx_gen();
+    int y2 = idx_gen();
+    if (y1 > y2) {
+      std::swap(y1, y2);
+    }
+    y1s.push_back(y1);
+    y2s.push_back(y2);
+    vals.push_back(search_gen());
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->fast_search(y1s[tc], y2s[tc], vals[tc]));
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
   return duration / ntc;
 }
 
@@ -122,8 +263,19 @@ const std::unordered_map<int, int> kNumEachPerOrder {
 };
 
 #define PLOT_DUMP
+#ifdef PLOT_DUMP
+  constexpr bool kPlotDump = true;
+#else
+  constexpr bool kPlotDump = false;
+#endif
 
-int main() {
+int main(int argc, char** argv) {
+  IndexPattern pattern;
+  if (!IndexPattern::from_args(argc, argv, &pattern)) {
+    fprintf(stderr, "Usage: %s [--pattern=%s]\n", argv[0],
+            IndexPattern::kUsage);
+    return 1;
+  }
   std::random_device rd;
   std::mt19937 prng(rd());
   std::uniform_int_distribution<int64_t> elem_dist(0, kMaxVal);
@@ -135,14 +287,17 @@ int main() {
     #else
       printf("%d\t", order);
     #endif
+    // Before allocating, the higher orders take gigabytes.
+    print_memory(Fenwick2D::memory_bytes(order), kBytes, kPlotDump);
     auto* ft = Fenwick2D::allocate(order);
     int n = (1 << order) - 1;
-    std::uniform_int_distribution<int> idx_dist(1, n);
-    auto idx_gen = [&]() { return idx_dist(prng); };
+    auto idx_gen = pattern.make(n, &prng);
     const int kNumEach = kNumEachPerOrder.at(order);
     // 1) Prefix Sum
     {
-      auto duration = measure_prefix_sum(ft, kNumEach, idx_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_prefix_sum(ft, kNumEach, idx_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x prefix_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -150,10 +305,15 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 2) Update
     {
-      auto duration = measure_update(ft, kNumEach, idx_gen, val_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration =
+          measure_update(ft, kNumEach, idx_gen, val_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x update: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -161,10 +321,14 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 3) Range Sum
     {
-      auto duration = measure_range_sum(ft, kNumEach, idx_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_range_sum(ft, kNumEach, idx_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x range_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -172,6 +336,41 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 4) Search
+    {
+      std::uniform_int_distribution<int64_t> search_dist(
+          1, ft->prefix_sum(n, n));
+      auto search_gen = [&]() { return search_dist(prng); };
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_search(ft, kNumEach, idx_gen, search_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x search: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 5) Fast Search
+    {
+      std::uniform_int_distribution<int64_t> search_dist(
+          1, ft->prefix_sum(n, n));
+      auto search_gen = [&]() { return search_dist(prng); };
+      PerfCounters perf(kPerfCounters);
+      auto duration =
+          measure_fast_search(ft, kNumEach, idx_gen, search_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x fast_search: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     free(ft);
     printf("\n");
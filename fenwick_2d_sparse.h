@@ -0,0 +1,162 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FENWICK_2D_SPARSE_H_
+#define FENWICK_2D_SPARSE_H_
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace fenwick {
+
+// Implements a static-layout sparse 2D Fenwick (Binary-Indexed) Tree. The set
+// of points that will ever be updated has to be known upfront. The x axis is
+// compressed to the distinct x coordinates of those points and every x node
+// keeps a sorted list of the y coordinates it covers, together with a 1D
+// Fenwick tree over that list. For k points this takes O(k log k) memory,
+// regardless of the size of the plane.
+// Consider that all the operations are performed on a fictive array a[x][y]
+// which is 0 everywhere except in the given points.
+struct Fenwick2DSparse {
+  // Builds the layout for the given (x, y) points and sets all the elements to
+  // 0. Duplicate points are allowed.
+  // Complexity: O(k log k)
+  explicit Fenwick2DSparse(const std::vector<std::pair<int, int>>& points) {
+    // Compress x.
+    for (const auto& p : points) {
+      xs.push_back(p.first);
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    n = xs.size();
+    // Count the (possibly repeated) y coordinates each x node covers.
+    offsets.assign(n + 2, 0);
+    for (const auto& p : points) {
+      for (int i = compress_x(p.first); i <= n; i += i & -i) {
+        offsets[i + 1]++;
+      }
+    }
+    for (int i = 1; i <= n + 1; i++) {
+      offsets[i] += offsets[i - 1];
+    }
+    // Fill the per-node y lists. Visiting the points by y keeps every list
+    // sorted without sorting each one separately.
+    std::vector<std::pair<int, int>> by_y(points);
+    std::sort(by_y.begin(), by_y.end(),
+              [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+                return a.second < b.second;
+              });
+    std::vector<int> pos(offsets.begin(), offsets.end() - 1);
+    ys.resize(offsets[n + 1]);
+    for (const auto& p : by_y) {
+      for (int i = compress_x(p.first); i <= n; i += i & -i) {
+        ys[pos[i]++] = p.second;
+      }
+    }
+    // Deduplicate each list, compacting the storage in place. The lists only
+    // move towards the front, so copying forward never overwrites a y that is
+    // still to be copied. Until the first duplicate nothing moves at all.
+    int size = 0;
+    for (int i = 1; i <= n; i++) {
+      int first = offsets[i];
+      int last = std::unique(ys.begin() + first, ys.begin() + offsets[i + 1]) -
+                 ys.begin();
+      offsets[i] = size;
+      if (size == first) {
+        size = last;
+        continue;
+      }
+      for (int j = first; j < last; j++) {
+        ys[size++] = ys[j];
+      }
+    }
+    offsets[n + 1] = size;
+    ys.resize(size);
+    ys.shrink_to_fit();
+    T.assign(size, 0LL);
+  }
+
+  // Sets all array elements to 0.
+  void clear() { std::fill(T.begin(), T.end(), 0LL); }
+
+  // Calculates the prefix sum: the sum of all a[x'][y'] with x' <= x and
+  // y' <= y.
+  // Complexity: O(log^2 k)
+  int64_t prefix_sum(int x, int y) const {
+    int64_t sum = 0;
+    for (int i = std::upper_bound(xs.begin(), xs.end(), x) - xs.begin();
+         i >= 1; i -= i & -i) {
+      int j = std::upper_bound(ys.begin() + offsets[i],
+                               ys.begin() + offsets[i + 1], y) -
+              (ys.begin() + offsets[i]);
+      for (; j >= 1; j -= j & -j) {
+        sum += T[offsets[i] + j - 1];
+      }
+    }
+    return sum;
+  }
+
+  // Adds delta to a[x][y].
+  // Complexity: O(log^2 k)
+  // Assumes that: (x, y) was one of the points given to the constructor.
+  void update(int x, int y, int64_t delta) {
+    for (int i = compress_x(x); i <= n; i += i & -i) {
+      int len = offsets[i + 1] - offsets[i];
+      int j = std::lower_bound(ys.begin() + offsets[i],
+                               ys.begin() + offsets[i + 1], y) -
+              (ys.begin() + offsets[i]) + 1;
+      for (; j <= len; j += j & -j) {
+        T[offsets[i] + j - 1] += delta;
+      }
+    }
+  }
+
+  // Calculates the range sum: the sum of all a[x][y] with x1 <= x <= x2 and
+  // y1 <= y <= y2.
+  // Complexity: O(log^2 k)
+  // Assumes that: x1 <= x2 and y1 <= y2.
+  int64_t range_sum(int x1, int y1, int x2, int y2) const {
+    return prefix_sum(x2, y2) - prefix_sum(x1 - 1, y2) -
+           prefix_sum(x2, y1 - 1) + prefix_sum(x1 - 1, y1 - 1);
+  }
+
+  // Number of distinct x coordinates, i.e. the size of the outer tree.
+  int n;
+  // Distinct x coordinates, sorted. Outer node i stands for xs[i - 1].
+  std::vector<int> xs;
+  // Node i owns ys[offsets[i]..offsets[i + 1]) and the same range of T.
+  std::vector<int> offsets;
+  // Sorted y coordinates covered by each outer node.
+  std::vector<int> ys;
+  // The inner trees storage, node i's tree is 1-indexed from T[offsets[i]].
+  std::vector<int64_t> T;
+
+ private:
+  // Returns the 1-based outer node index of x.
+  // Assumes that: x is present in xs.
+  int compress_x(int x) const {
+    return std::lower_bound(xs.begin(), xs.end(), x) - xs.begin() + 1;
+  }
+};
+
+}  // namespace fenwick
+
+#endif  // FENWICK_2D_SPARSE_H_
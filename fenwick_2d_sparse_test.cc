@@ -0,0 +1,126 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "fenwick_2d_sparse.h"
+
+using fenwick::Fenwick2DSparse;
+
+constexpr int kNumTestCases = 1000;
+constexpr int kNumSessions = 20;
+constexpr int kQueriesPerSession = 10;
+constexpr int kUpdatesPerSession = 10;
+
+constexpr int kMaxPoints = 200;
+// Small enough for the points to share coordinates and repeat.
+constexpr int kMaxCoord = 50;
+constexpr int kMaxVal = 1000;
+
+// Sums the values of the points in [x1, x2] x [y1, y2], one by one.
+int64_t box_sum(const std::vector<std::pair<int, int>>& points,
+                const std::vector<int64_t>& vals, int x1, int y1, int x2,
+                int y2) {
+  int64_t sum = 0;
+  for (size_t i = 0; i < points.size(); i++) {
+    if (x1 <= points[i].first && points[i].first <= x2 &&
+        y1 <= points[i].second && points[i].second <= y2) {
+      sum += vals[i];
+    }
+  }
+  return sum;
+}
+
+// Runs random updates on the registered points, and prefix and range sums
+// anywhere on and around the plane, checking them against a scan of the
+// points. Duplicates share the value of their first occurrence.
+void test(std::mt19937& prng) {
+  std::uniform_int_distribution<int> kgen(0, kMaxPoints);
+  std::uniform_int_distribution<int> cgen(1, kMaxCoord);
+  // Queries also go past the plane on both sides.
+  std::uniform_int_distribution<int> qgen(-1, kMaxCoord + 2);
+  std::uniform_int_distribution<int64_t> vgen(-kMaxVal, kMaxVal);
+
+  for (int tc = 1; tc <= kNumTestCases; tc++) {
+    int k = kgen(prng);
+    std::vector<std::pair<int, int>> points;
+    for (int i = 0; i < k; i++) {
+      points.emplace_back(cgen(prng), cgen(prng));
+    }
+    Fenwick2DSparse ft(points);
+    // Distinct points only, for the brute force.
+    std::vector<std::pair<int, int>> distinct(points);
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()),
+                   distinct.end());
+    std::vector<int64_t> vals(distinct.size(), 0);
+    for (int s = 0; s < kNumSessions; s++) {
+      for (int u = 0; u < kUpdatesPerSession && k > 0; u++) {
+        int i = std::uniform_int_distribution<int>(0, k - 1)(prng);
+        int64_t delta = vgen(prng);
+        ft.update(points[i].first, points[i].second, delta);
+        vals[std::lower_bound(distinct.begin(), distinct.end(), points[i]) -
+             distinct.begin()] += delta;
+      }
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        int x = qgen(prng);
+        int y = qgen(prng);
+        assert(ft.prefix_sum(x, y) == box_sum(distinct, vals, 0, 0, x, y));
+        int x1 = qgen(prng);
+        int x2 = qgen(prng);
+        int y1 = qgen(prng);
+        int y2 = qgen(prng);
+        if (x1 > x2) {
+          std::swap(x1, x2);
+        }
+        if (y1 > y2) {
+          std::swap(y1, y2);
+        }
+        assert(ft.range_sum(x1, y1, x2, y2) ==
+               box_sum(distinct, vals, x1, y1, x2, y2));
+      }
+    }
+    // Every x node only lists the y coordinates it covers, sorted and unique.
+    for (int i = 1; i <= ft.n; i++) {
+      assert(std::is_sorted(ft.ys.begin() + ft.offsets[i],
+                            ft.ys.begin() + ft.offsets[i + 1]));
+      assert(std::adjacent_find(ft.ys.begin() + ft.offsets[i],
+                                ft.ys.begin() + ft.offsets[i + 1]) ==
+             ft.ys.begin() + ft.offsets[i + 1]);
+    }
+    ft.clear();
+    assert(ft.range_sum(0, 0, kMaxCoord, kMaxCoord) == 0);
+  }
+}
+
+int main() {
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  test(prng);
+  printf("Success!\n");
+  return 0;
+}
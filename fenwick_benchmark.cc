@@ -23,6 +23,7 @@
 #include <cstdlib>
 #include <functional>
 #include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -30,9 +31,31 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
+#include "benchmark_baselines.h"
+#include "benchmark_bytes.h"
+#include "benchmark_cache.h"
+#include "benchmark_latency.h"
+#include "benchmark_index_gen.h"
+#include "benchmark_perf.h"
 #include "fenwick.h"
 
 using fenwick::Fenwick;
+using fenwick::bench::CacheSamples;
+using fenwick::bench::down_walk;
+using fenwick::bench::print_bytes;
+using fenwick::bench::print_counters;
+using fenwick::bench::print_memory;
+using fenwick::bench::up_walk;
+using fenwick::bench::LatencyHistogram;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::PerfCounters;
+using fenwick::bench::PrefixArray;
+using fenwick::bench::SegmentTree;
+using fenwick::bench::SqrtBlocks;
+using fenwick::bench::keep;
+using fenwick::bench::sample_cache_modes;
+using fenwick::bench::sample_latencies;
+using fenwick::bench::touch;
 
 ////////////////////////////////////////////////////////////////////////////////
 // MEASUREMENT METHODS
@@ -40,25 +63,142 @@ using fenwick::Fenwick;
 
 // #define VERIFY
 
-absl::Duration measure_prefix_sum(Fenwick* ft, int ntc,
-                                  std::function<int64_t()> idx_gen) {
+// Count hardware events (see benchmark_perf.h) around each measured loop and
+// report them per operation.
+// #define PERF_COUNTERS
+#ifdef PERF_COUNTERS
+  constexpr bool kPerfCounters = true;
+#else
+  constexpr bool kPerfCounters = false;
+#endif
+
+// Besides the mean, time each operation separately and report percentiles.
+// The constructions are left out, they are bulk operations.
+// #define LATENCY
+#ifdef LATENCY
+  constexpr bool kLatency = true;
+#else
+  constexpr bool kLatency = false;
+#endif
+// Time every kLatencyPeriod-th operation, in a pass of it's own after the mean
+// loop. The calls in between run untimed, so the fences around the timed ones
+// barely disturb the pipeline. At the large orders, with 50 to 100 calls, only
+// a handful get timed and the percentiles are coarse.
+constexpr int kLatencyPeriod = 16;
+
+// Report the memory footprint of every order, and the bytes the operations
+// touch (see benchmark_bytes.h) together with the bandwidth that amounts to.
+// #define BYTES
+#ifdef BYTES
+  constexpr bool kBytes = true;
+#else
+  constexpr bool kBytes = false;
+#endif
+
+// Bytes prefix_sum(idx) and update(idx, ...) touch, per structure.
+int64_t prefix_sum_bytes(const Fenwick&, int idx) {
+  return down_walk(idx) * sizeof(int64_t);
+}
+int64_t update_bytes(const Fenwick& ft, int idx) {
+  return up_walk(idx, ft.n) * sizeof(int64_t);
+}
+int64_t prefix_sum_bytes(const PrefixArray&, int) { return sizeof(int64_t); }
+int64_t update_bytes(const PrefixArray& pa, int idx) {
+  return (pa.n - idx + 1) * sizeof(int64_t);
+}
+int64_t prefix_sum_bytes(const SegmentTree& st, int idx) {
+  int nodes = 0;
+  for (int lo = st.size, hi = idx + st.size; lo < hi; lo >>= 1, hi >>= 1) {
+    nodes += (lo & 1) + (hi & 1);
+    lo += lo & 1;
+    hi -= hi & 1;
+  }
+  return nodes * sizeof(int64_t);
+}
+int64_t update_bytes(const SegmentTree& st, int) {
+  int nodes = 0;
+  for (int p = st.size; p >= 1; p >>= 1) {
+    nodes++;
+  }
+  return nodes * sizeof(int64_t);
+}
+int64_t prefix_sum_bytes(const SqrtBlocks& sb, int idx) {
+  int block = idx >> sb.shift;
+  return (block + idx - (block << sb.shift) + 1) * sizeof(int64_t);
+}
+int64_t update_bytes(const SqrtBlocks&, int) { return 2 * sizeof(int64_t); }
+
+// Time a sample of the prefix sums and the updates one by one with the caches
+// flushed (cold) and with the structure read in beforehand (warm), see
+// benchmark_cache.h. At the small orders the mean loops only ever see the
+// latter.
+// #define CACHE_MODES
+#ifdef CACHE_MODES
+  constexpr bool kCacheModes = true;
+#else
+  constexpr bool kCacheModes = false;
+#endif
+// Every cold operation streams through the flush buffer, so only the first
+// kCacheSamples operations are timed.
+constexpr int kCacheSamples = 100;
+
+// Brings the whole structure into the caches.
+void warm(const Fenwick& ft) { touch(&ft, ft.memory_bytes()); }
+void warm(const PrefixArray& pa) {
+  touch(pa.sums.data(), pa.sums.size() * sizeof(int64_t));
+}
+void warm(const SegmentTree& st) {
+  touch(st.t.data(), st.t.size() * sizeof(int64_t));
+}
+void warm(const SqrtBlocks& sb) {
+  touch(sb.a.data(), sb.a.size() * sizeof(int64_t));
+  touch(sb.blocks.data(), sb.blocks.size() * sizeof(int64_t));
+}
+
+// The prefix sums and the updates are also measured on the reference
+// structures (see benchmark_baselines.h), hence the templates.
+template <typename Tree>
+absl::Duration measure_prefix_sum(Tree* ft, int ntc,
+                                  std::function<int64_t()> idx_gen,
+                                  LatencyHistogram* hist, CacheSamples* cache,
+                                  PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> idxs;
   for (int i = 0; i < ntc; i++) {
     idxs.push_back(idx_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->prefix_sum(idxs[tc]);
+    keep(ft->prefix_sum(idxs[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->prefix_sum(idxs[tc]); });
+  }
+  if (kCacheModes) {
+    sample_cache_modes(ntc, kCacheSamples, [&]() { warm(*ft); }, cache,
+                       [&](int tc) { return ft->prefix_sum(idxs[tc]); });
+  }
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += prefix_sum_bytes(*ft, idxs[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
-absl::Duration measure_update(Fenwick* ft, int ntc,
+template <typename Tree>
+absl::Duration measure_update(Tree* ft, int ntc,
                               std::function<int()> idx_gen,
-                              std::function<int64_t()> val_gen) {
+                              std::function<int64_t()> val_gen,
+                              LatencyHistogram* hist, CacheSamples* cache,
+                              PerfCounters* perf, double* bytes) {
   // Generate
   std::vector<int> idxs;
   std::vector<int64_t> vals;
@@ -67,16 +207,34 @@ absl::Duration measure_update(Fenwick* ft, int ntc,
     vals.push_back(val_gen());
   }
   // Do the updates.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     ft->update(idxs[tc], vals[tc]);
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { ft->update(idxs[tc], vals[tc]); });
+  }
+  if (kCacheModes) {
+    sample_cache_modes(ntc, kCacheSamples, [&]() { warm(*ft); }, cache,
+                       [&](int tc) { ft->update(idxs[tc], vals[tc]); });
+  }
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += update_bytes(*ft, idxs[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_construct(Fenwick* ft, int n, int ntc,
-                                 std::function<int64_t()> val_gen) {
+                                 std::function<int64_t()> val_gen,
+                                 PerfCounters* perf) {
   // Generate.
   std::vector<int64_t*> arrays(ntc);
   for (int64_t*& a : arrays) {
@@ -86,6 +244,7 @@ absl::Duration measure_construct(Fenwick* ft, int n, int ntc,
     }
   }
   // Do the constructions.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     ft->construct(arrays[tc]);
@@ -96,6 +255,7 @@ absl::Duration measure_construct(Fenwick* ft, int n, int ntc,
     #endif
   }
   auto duration = absl::Now() - start;
+  perf->stop();
   // Cleanup after construction.
   for (int64_t*& a : arrays) {
     delete[] a;
@@ -104,7 +264,8 @@ absl::Duration measure_construct(Fenwick* ft, int n, int ntc,
 }
 
 absl::Duration measure_fast_construct(Fenwick* ft, int n, int ntc,
-                                      std::function<int64_t()> val_gen) {
+                                      std::function<int64_t()> val_gen,
+                                      PerfCounters* perf) {
   // Generate.
   std::vector<int64_t*> arrays(ntc);
   for (int64_t*& a : arrays) {
@@ -114,6 +275,7 @@ absl::Duration measure_fast_construct(Fenwick* ft, int n, int ntc,
     }
   }
   // Do the constructions.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     #ifdef VERIFY
@@ -127,6 +289,7 @@ absl::Duration measure_fast_construct(Fenwick* ft, int n, int ntc,
     #endif
   }
   auto duration = absl::Now() - start;
+  perf->stop();
   // Cleanup after construction.
   for (int64_t*& a : arrays) {
     delete[] a;
@@ -135,79 +298,113 @@ absl::Duration measure_fast_construct(Fenwick* ft, int n, int ntc,
 }
 
 absl::Duration measure_access(Fenwick* ft, int ntc,
-                              std::function<int()> idx_gen) {
+                              std::function<int()> idx_gen,
+                              LatencyHistogram* hist,
+                              PerfCounters* perf) {
   // Generate.
   std::vector<int> idxs;
   for (int i = 0; i < ntc; i++) {
     idxs.push_back(idx_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     #ifndef VERIFY
-      ft->access(idxs[tc]);
+      keep(ft->access(idxs[tc]));
     #else
       assert(ft->access(idxs[tc]) == ft->fast_access(idxs[tc]));
     #endif
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->access(idxs[tc]); });
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_fast_access(Fenwick* ft, int ntc,
-                                   std::function<int()> idx_gen) {
+                                   std::function<int()> idx_gen,
+                                   LatencyHistogram* hist,
+                                   PerfCounters* perf) {
   // Generate.
   std::vector<int> idxs;
   for (int i = 0; i < ntc; i++) {
     idxs.push_back(idx_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->fast_access(idxs[tc]);
+    keep(ft->fast_access(idxs[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->fast_access(idxs[tc]); });
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_search(Fenwick* ft, int ntc,
-                              std::function<int64_t()> search_gen) {
+                              std::function<int64_t()> search_gen,
+                              LatencyHistogram* hist,
+                              PerfCounters* perf) {
   // Generate ntc values to search for.
   std::vector<int64_t> vals;
   for (int i = 0; i < ntc; i++) {
     vals.push_back(search_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     #ifndef VERIFY
-      ft->search(vals[tc]);
+      keep(ft->search(vals[tc]));
     #else
       assert(ft->search(vals[tc]) == ft->fast_search(vals[tc]));
     #endif
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->search(vals[tc]); });
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_fast_search(Fenwick* ft, int ntc,
-                                   std::function<int64_t()> search_gen) {
+                                   std::function<int64_t()> search_gen,
+                                   LatencyHistogram* hist,
+                                   PerfCounters* perf) {
   // Generate ntc values to search for.
   std::vector<int64_t> vals;
   for (int i = 0; i < ntc; i++) {
     vals.push_back(search_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->fast_search(vals[tc]);
+    keep(ft->fast_search(vals[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->fast_search(vals[tc]); });
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_range_sum(Fenwick* ft, int ntc,
-                                 std::function<int()> idx_gen) {
+                                 std::function<int()> idx_gen,
+                                 LatencyHistogram* hist,
+                                 PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> ls;
   std::vector<int> rs;
@@ -221,21 +418,37 @@ absl::Duration measure_range_sum(Fenwick* ft, int ntc,
     rs.push_back(r);
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     #ifndef VERIFY
-      ft->range_sum(ls[tc], rs[tc]);
+      keep(ft->range_sum(ls[tc], rs[tc]));
     #else
       assert(ft->range_sum(ls[tc], rs[tc]) ==
              ft->fast_range_sum(ls[tc], rs[tc]));
     #endif
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist,
+                     [&](int tc) { return ft->range_sum(ls[tc], rs[tc]); });
+  }
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total +=
+          prefix_sum_bytes(*ft, rs[tc]) + prefix_sum_bytes(*ft, ls[tc] - 1);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_fast_range_sum(Fenwick* ft, int ntc,
-                                      std::function<int()> idx_gen) {
+                                      std::function<int()> idx_gen,
+                                      LatencyHistogram* hist,
+                                      PerfCounters* perf) {
   // Generate.
   std::vector<int> ls;
   std::vector<int> rs;
@@ -249,17 +462,26 @@ absl::Duration measure_fast_range_sum(Fenwick* ft, int ntc,
     rs.push_back(r);
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->fast_range_sum(ls[tc], rs[tc]);
+    keep(ft->fast_range_sum(ls[tc], rs[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist, [&](int tc) {
+      return ft->fast_range_sum(ls[tc], rs[tc]);
+    });
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_rupq_update(Fenwick* ft, int ntc,
                                    std::function<int()> idx_gen,
-                                   std::function<int()> val_gen) {
+                                   std::function<int()> val_gen,
+                                   LatencyHistogram* hist,
+                                   PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> ls;
   std::vector<int> rs;
@@ -275,11 +497,25 @@ absl::Duration measure_rupq_update(Fenwick* ft, int ntc,
     vals.push_back(val_gen());
   }
   // Do the updates.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     ft->rupq_update(ls[tc], rs[tc], vals[tc]);
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kLatency) {
+    sample_latencies(ntc, kLatencyPeriod, hist, [&](int tc) {
+      ft->rupq_update(ls[tc], rs[tc], vals[tc]);
+    });
+  }
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += update_bytes(*ft, ls[tc]) + update_bytes(*ft, rs[tc] + 1);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
@@ -296,8 +532,109 @@ const std::unordered_map<int, int> kNumEachPerOrder {
 };
 
 #define PLOT_DUMP
+#ifdef PLOT_DUMP
+  constexpr bool kPlotDump = true;
+#else
+  constexpr bool kPlotDump = false;
+#endif
+
+void print_latency(const LatencyHistogram& hist) {
+  if (!kLatency) {
+    return;
+  }
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "p50: $0 p99: $1 p999: $2",
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.99))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.999))));
+    printf("    %s\n", msg.c_str());
+  #else
+    printf("%15.3lf\t%15.3lf\t%15.3lf\t", hist.percentile(0.5),
+           hist.percentile(0.99), hist.percentile(0.999));
+  #endif
+}
+
+// Prints the mean and the median latency of the warm and the cold samples,
+// side by side.
+void print_cache(const CacheSamples& cache) {
+  if (!kCacheModes) {
+    return;
+  }
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "warm mean: $0 p50: $1 cold mean: $2 p50: $3",
+        absl::FormatDuration(absl::Nanoseconds(cache.warm.mean())),
+        absl::FormatDuration(absl::Nanoseconds(cache.warm.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(cache.cold.mean())),
+        absl::FormatDuration(absl::Nanoseconds(cache.cold.percentile(0.5))));
+    printf("    %s\n", msg.c_str());
+  #else
+    printf("%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\t", cache.warm.mean(),
+           cache.warm.percentile(0.5), cache.cold.mean(),
+           cache.cold.percentile(0.5));
+  #endif
+}
+
+// Measures the prefix sums and the updates on a reference structure of the
+// same size, with the same kind of inputs as the Fenwick tree gets.
+template <typename Tree>
+void run_reference(const char* name, int order, int ntc,
+                   std::function<int()> idx_gen,
+                   std::function<int64_t()> val_gen) {
+  Tree tree(order);
+  // The columns of PLOT_DUMP go without names.
+  static_cast<void>(name);
+  print_memory(tree.memory_bytes(), kBytes, kPlotDump);
+  // Prefix Sum
+  {
+    LatencyHistogram hist;
+    CacheSamples cache;
+    PerfCounters perf(kPerfCounters);
+    double bytes = 0;
+    auto duration = measure_prefix_sum(&tree, ntc, idx_gen, &hist, &cache,
+                                       &perf, &bytes);
+    #ifndef PLOT_DUMP
+      auto msg = absl::Substitute("$0 x $1 prefix_sum: $2: ", ntc, name,
+                                  absl::FormatDuration(duration));
+      printf("  %s\n", msg.c_str());
+    #else
+      printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+    #endif
+    print_bytes(bytes, duration, kBytes, kPlotDump);
+    print_latency(hist);
+    print_cache(cache);
+    print_counters(perf, ntc, kPerfCounters, kPlotDump);
+  }
+  // Update
+  {
+    LatencyHistogram hist;
+    CacheSamples cache;
+    PerfCounters perf(kPerfCounters);
+    double bytes = 0;
+    auto duration = measure_update(&tree, ntc, idx_gen, val_gen, &hist,
+                                   &cache, &perf, &bytes);
+    #ifndef PLOT_DUMP
+      auto msg = absl::Substitute("$0 x $1 update: $2: ", ntc, name,
+                                  absl::FormatDuration(duration));
+      printf("  %s\n", msg.c_str());
+    #else
+      printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+    #endif
+    print_bytes(bytes, duration, kBytes, kPlotDump);
+    print_latency(hist);
+    print_cache(cache);
+    print_counters(perf, ntc, kPerfCounters, kPlotDump);
+  }
+}
 
-int main() {
+int main(int argc, char** argv) {
+  IndexPattern pattern;
+  if (!IndexPattern::from_args(argc, argv, &pattern)) {
+    fprintf(stderr, "Usage: %s [--pattern=%s]\n", argv[0],
+            IndexPattern::kUsage);
+    return 1;
+  }
   std::random_device rd;
   std::mt19937 prng(rd());
   std::uniform_int_distribution<int64_t> elem_dist(0, kMaxVal);
@@ -311,12 +648,17 @@ int main() {
     #endif
     auto* ft = Fenwick::allocate(order);
     int n = (1 << order) - 1;
-    std::uniform_int_distribution<int> idx_dist(1, n);
-    auto idx_gen = [&]() { return idx_dist(prng); };
+    print_memory(ft->memory_bytes(), kBytes, kPlotDump);
+    auto idx_gen = pattern.make(n, &prng);
     const int kNumEach = kNumEachPerOrder.at(order);
     // 1) Prefix Sum
     {
-      auto duration = measure_prefix_sum(ft, kNumEach, idx_gen);
+      LatencyHistogram hist;
+      CacheSamples cache;
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_prefix_sum(ft, kNumEach, idx_gen, &hist, &cache,
+                                         &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x prefix_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -324,10 +666,19 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_latency(hist);
+      print_cache(cache);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 2) Update
     {
-      auto duration = measure_update(ft, kNumEach, idx_gen, val_gen);
+      LatencyHistogram hist;
+      CacheSamples cache;
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_update(ft, kNumEach, idx_gen, val_gen, &hist,
+                                     &cache, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x update: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -335,11 +686,16 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_latency(hist);
+      print_cache(cache);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 3) Construction
     {
       ft->clear();
-      auto duration = measure_construct(ft, n, kNumEach, val_gen);
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_construct(ft, n, kNumEach, val_gen, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x construct: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -347,10 +703,20 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      // Reads a once, and an update walk from every index.
+      if (kBytes) {
+        int64_t bytes = n * sizeof(int64_t);
+        for (int i = 1; i <= n; i++) {
+          bytes += update_bytes(*ft, i);
+        }
+        print_bytes(bytes, duration, kBytes, kPlotDump);
+      }
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 4) Fast Construction
     {
-      auto duration = measure_fast_construct(ft, n, kNumEach, val_gen);
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_fast_construct(ft, n, kNumEach, val_gen, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x fast_construct: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -358,10 +724,15 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      // Two passes over a, one over T.
+      print_bytes(3.0 * n * sizeof(int64_t), duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 5) Access
     {
-      auto duration = measure_access(ft, kNumEach, idx_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_access(ft, kNumEach, idx_gen, &hist, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x access: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -369,10 +740,14 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 6) Fast Access
     {
-      auto duration = measure_fast_access(ft, kNumEach, idx_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_fast_access(ft, kNumEach, idx_gen, &hist, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x fast_access: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -380,13 +755,17 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 7) Search
     {
       std::uniform_int_distribution<int64_t> search_dist(
           1, ft->prefix_sum(n) * 2);
       auto search_gen = [&]() { return search_dist(prng); };
-      auto duration = measure_search(ft, kNumEach, search_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_search(ft, kNumEach, search_gen, &hist, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x search: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -394,13 +773,18 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 8) Fast Search
     {
       std::uniform_int_distribution<int64_t> search_dist(
           1, ft->prefix_sum(n) * 2);
       auto search_gen = [&]() { return search_dist(prng); };
-      auto duration = measure_fast_search(ft, kNumEach, search_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      auto duration =
+          measure_fast_search(ft, kNumEach, search_gen, &hist, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x fast_search: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -408,10 +792,16 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 9) Range Sum
     {
-      auto duration = measure_range_sum(ft, kNumEach, idx_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration =
+          measure_range_sum(ft, kNumEach, idx_gen, &hist, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x range_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -419,10 +809,16 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 10) Fast Range Sum
     {
-      auto duration = measure_fast_range_sum(ft, kNumEach, idx_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      auto duration =
+          measure_fast_range_sum(ft, kNumEach, idx_gen, &hist, &perf);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x fast_range_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -430,11 +826,17 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 11) RUPQ Update
     {
       ft->clear();
-      auto duration = measure_rupq_update(ft, kNumEach, idx_gen, val_gen);
+      LatencyHistogram hist;
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_rupq_update(ft, kNumEach, idx_gen, val_gen,
+                                          &hist, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x rupq_update: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -442,8 +844,18 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_latency(hist);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     free(ft);
+    // 12) - 14) The references: prefix sum array, segment tree, sqrt blocks.
+    run_reference<PrefixArray>("prefix_array", order, kNumEach, idx_gen,
+                               val_gen);
+    run_reference<SegmentTree>("segment_tree", order, kNumEach, idx_gen,
+                               val_gen);
+    run_reference<SqrtBlocks>("sqrt_blocks", order, kNumEach, idx_gen,
+                              val_gen);
     printf("\n");
   }
   return 0;
@@ -0,0 +1,174 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "benchmark_workload.h"
+
+using fenwick::bench::FenwickWorkload;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::Op;
+using fenwick::bench::PrefixArray;
+using fenwick::bench::ReferenceWorkload;
+using fenwick::bench::RMQWorkload;
+using fenwick::bench::RURQWorkload;
+using fenwick::bench::SegmentTree;
+using fenwick::bench::SqrtBlocks;
+using fenwick::bench::apply_ops;
+using fenwick::bench::gen_ops;
+using fenwick::bench::keep;
+using fenwick::bench::parse_flags;
+using fenwick::bench::parse_mix;
+
+// Measures the throughput of one structure under a mix of interleaved reads
+// and writes, e.g.
+//   fenwick_mixed_benchmark --structure=fenwick --order=20
+//       --mix=update:10,prefix_sum:80,fast_search:10 --batch=16 --threads=4
+// All the threads share one instance. Operations are issued in batches, a
+// batch holds the instance's lock in reader mode if it only reads, and in
+// writer mode otherwise.
+// The prefix_array, segment_tree and sqrt_blocks structures are the references
+// of benchmark_baselines.h, with update, prefix_sum and range_sum, to find the
+// mixes where they beat the Fenwick tree.
+
+struct Config {
+  std::string structure = "fenwick";
+  int order = 20;
+  std::string mix;
+  int batch = 1;
+  int threads = 1;
+  int64_t ops = 1000000;
+  IndexPattern pattern;
+};
+
+#define PLOT_DUMP
+
+// Runs the configured mix on Workload, prints the throughput. Returns false if
+// the mix is malformed.
+template <typename Workload>
+bool run(const Config& config) {
+  std::vector<double> weights;
+  std::string mix = config.mix.empty() ? Workload::kDefaultMix : config.mix;
+  if (!parse_mix<Workload>(mix, &weights)) {
+    fprintf(stderr, "Bad mix: %s\n", mix.c_str());
+    return false;
+  }
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  Workload workload(config.order, &prng);
+  absl::Mutex mu;
+
+  // Each thread generates it's operations, then waits for the others.
+  absl::BlockingCounter generated(config.threads);
+  absl::Notification go;
+  int64_t ops_per_thread = config.ops / config.threads;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < config.threads; t++) {
+    unsigned seed = rd();
+    threads.emplace_back([&, seed]() {
+      std::vector<Op> ops =
+          gen_ops(workload, weights, config.pattern, ops_per_thread, seed);
+      generated.DecrementCount();
+      go.WaitForNotification();
+      keep(apply_ops(&workload, ops, config.batch, &mu, nullptr, 1));
+    });
+  }
+  generated.Wait();
+  auto start = absl::Now();
+  go.Notify();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto duration = absl::Now() - start;
+  double ops_per_sec =
+      ops_per_thread * config.threads / absl::ToDoubleSeconds(duration);
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "$0 order $1, $2 thread(s), batch $3, $4: $5 x ops in $6: $7 ops/s",
+        config.structure, config.order, config.threads, config.batch, mix,
+        ops_per_thread * config.threads, absl::FormatDuration(duration),
+        ops_per_sec);
+    printf("%s\n", msg.c_str());
+  #else
+    printf("%s\t%d\t%d\t%d\t%s\t%15.3lf\n", config.structure.c_str(),
+           config.order, config.threads, config.batch, mix.c_str(),
+           ops_per_sec);
+  #endif
+  return true;
+}
+
+// Parses the command line into config. Returns false on a bad argument.
+bool parse_args(int argc, char** argv, Config* config) {
+  if (!parse_flags(argc, argv,
+                   {{"structure", &config->structure},
+                    {"order", &config->order},
+                    {"mix", &config->mix},
+                    {"batch", &config->batch},
+                    {"threads", &config->threads},
+                    {"ops", &config->ops},
+                    {"pattern", &config->pattern}})) {
+    return false;
+  }
+  return config->order >= 1 && config->order <= 30 && config->batch >= 1 &&
+         config->threads >= 1 && config->ops >= config->threads;
+}
+
+int main(int argc, char** argv) {
+  Config config;
+  if (!parse_args(argc, argv, &config)) {
+    fprintf(stderr,
+            "Usage: %s [--structure=fenwick|rurq|rmq|prefix_array|"
+            "segment_tree|sqrt_blocks] [--order=20] "
+            "[--mix=op:weight,...] [--batch=1] [--threads=1] [--ops=1000000] "
+            "[--pattern=%s]\n",
+            argv[0], IndexPattern::kUsage);
+    return 1;
+  }
+  bool ok = false;
+  if (config.structure == "fenwick") {
+    ok = run<FenwickWorkload>(config);
+  } else if (config.structure == "rurq") {
+    ok = run<RURQWorkload>(config);
+  } else if (config.structure == "rmq") {
+    ok = run<RMQWorkload>(config);
+  } else if (config.structure == "prefix_array") {
+    ok = run<ReferenceWorkload<PrefixArray>>(config);
+  } else if (config.structure == "segment_tree") {
+    ok = run<ReferenceWorkload<SegmentTree>>(config);
+  } else if (config.structure == "sqrt_blocks") {
+    ok = run<ReferenceWorkload<SqrtBlocks>>(config);
+  } else {
+    fprintf(stderr, "Unknown structure: %s\n", config.structure.c_str());
+  }
+  return ok ? 0 : 1;
+}
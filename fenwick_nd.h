@@ -0,0 +1,169 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FENWICK_ND_H_
+#define FENWICK_ND_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <type_traits>
+
+namespace fenwick {
+
+// Implements D-dimensional Fenwick (Binary-Indexed) Tree data strucutre with
+// it's basic operations. Consider that all the operations are performed on a
+// fictive array a[1..n]...[1..n] (D times).
+//
+// The nested lowbit loops, one per dimension, are generated at compile time.
+// Node [i_0]...[i_(D-1)] is stored at offset
+// ((i_0 * (n + 1) + i_1) * (n + 1) + ...) + i_(D-1), so the innermost loop
+// walks the contiguous dimension.
+template <int D, typename T>
+struct FenwickND {
+  static_assert(D >= 1, "FenwickND needs at least one dimension.");
+  static_assert(std::is_arithmetic<T>::value,
+                "FenwickND is allocated with malloc(3), T must be arithmetic.");
+
+  using Index = std::array<int, D>;
+
+  // Allocates the structure of size n x ... x n, n = 2^m - 1 and sets all the
+  // elements to 0. This is the one true way of creating this struct.
+  // Delete with free(3).
+  static FenwickND* allocate(int m) {
+    int n = (1 << m) - 1;
+    size_t size = storage_size(n);
+    FenwickND* instance = reinterpret_cast<FenwickND*>(
+        malloc(sizeof(FenwickND) + size * sizeof(T)));
+    instance->n = n;
+    std::fill_n(instance->tree, size, T());
+    return instance;
+  }
+
+  // Disable other creation, copying ans assigning.
+  FenwickND() = delete;
+  FenwickND(const FenwickND&) = delete;
+  void operator=(const FenwickND&) = delete;
+
+  // Sets all array elements to 0.
+  void clear() { std::fill_n(tree, storage_size(n), T()); }
+
+  // Calculates the prefix sum: a[1:idx[0]]...[1:idx[D-1]].
+  // Complexity: O(log^D n)
+  // Assumes that: 1 <= idx[k] <= n for all k.
+  T prefix_sum(const Index& idx) const {
+    return prefix_sum_impl(idx, 0, std::integral_constant<int, 0>());
+  }
+
+  // Adds delta to a[idx[0]]...[idx[D-1]].
+  // Complexity: O(log^D n)
+  // Assumes that: 1 <= idx[k] <= n for all k.
+  void update(const Index& idx, T delta) {
+    update_impl(idx, 0, delta, std::integral_constant<int, 0>());
+  }
+
+  // Calculates the range sum: a[lo[0]:hi[0]]...[lo[D-1]:hi[D-1]].
+  // Complexity: O(2^D log^D n)
+  // Assumes that: 1 <= lo[k] <= hi[k] <= n for all k.
+  T range_sum(const Index& lo, const Index& hi) const {
+    T sum = T();
+    // Inclusion-exclusion over the 2^D corners of the box, skipping the ones
+    // that touch the (empty) 0 border.
+    for (int mask = 0; mask < (1 << D); mask++) {
+      Index corner;
+      bool negative = false;
+      bool empty = false;
+      for (int k = 0; k < D; k++) {
+        if (mask & (1 << k)) {
+          corner[k] = lo[k] - 1;
+          negative = !negative;
+          empty = empty || corner[k] == 0;
+        } else {
+          corner[k] = hi[k];
+        }
+      }
+      if (empty) {
+        continue;
+      }
+      if (negative) {
+        sum -= prefix_sum(corner);
+      } else {
+        sum += prefix_sum(corner);
+      }
+    }
+    return sum;
+  }
+
+  // Number of nodes in the tree storage array, (n + 1)^D.
+  static size_t storage_size(int n) {
+    size_t size = 1;
+    for (int k = 0; k < D; k++) {
+      size *= n + 1;
+    }
+    return size;
+  }
+
+  // Size of the tree and the fictive array a are n x ... x n.
+  int n;
+  // The tree storage array.
+  T tree[];
+
+ private:
+  // Walks the dimension K, base is the offset of the node prefix built by the
+  // outer dimensions.
+  template <int K>
+  T prefix_sum_impl(const Index& idx, size_t base,
+                    std::integral_constant<int, K>) const {
+    T sum = T();
+    for (int i = idx[K]; i >= 1; i -= i & -i) {
+      sum += prefix_sum_impl(idx, (base + i) * (n + 1),
+                             std::integral_constant<int, K + 1>());
+    }
+    return sum;
+  }
+  T prefix_sum_impl(const Index& idx, size_t base,
+                    std::integral_constant<int, D - 1>) const {
+    T sum = T();
+    for (int i = idx[D - 1]; i >= 1; i -= i & -i) {
+      sum += tree[base + i];
+    }
+    return sum;
+  }
+
+  template <int K>
+  void update_impl(const Index& idx, size_t base, T delta,
+                   std::integral_constant<int, K>) {
+    for (int i = idx[K]; i <= n; i += i & -i) {
+      update_impl(idx, (base + i) * (n + 1), delta,
+                  std::integral_constant<int, K + 1>());
+    }
+  }
+  void update_impl(const Index& idx, size_t base, T delta,
+                   std::integral_constant<int, D - 1>) {
+    for (int i = idx[D - 1]; i <= n; i += i & -i) {
+      tree[base + i] += delta;
+    }
+  }
+};
+
+}  // namespace fenwick
+
+#endif  // FENWICK_ND_H_
@@ -0,0 +1,186 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "benchmark_latency.h"
+#include "fenwick_nd.h"
+
+using fenwick::FenwickND;
+using fenwick::bench::keep;
+
+////////////////////////////////////////////////////////////////////////////////
+// MEASUREMENT METHODS
+////////////////////////////////////////////////////////////////////////////////
+
+template <int D>
+absl::Duration measure_prefix_sum(FenwickND<D, int64_t>* ft, int ntc,
+                                  std::function<int()> idx_gen) {
+  // Generate ntc indexes to query.
+  std::vector<std::array<int, D>> idxs(ntc);
+  for (auto& idx : idxs) {
+    for (int& i : idx) {
+      i = idx_gen();
+    }
+  }
+  // Do the queries.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->prefix_sum(idxs[tc]));
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+template <int D>
+absl::Duration measure_range_sum(FenwickND<D, int64_t>* ft, int ntc,
+                                 std::function<int()> idx_gen) {
+  // Generate.
+  std::vector<std::array<int, D>> los(ntc);
+  std::vector<std::array<int, D>> his(ntc);
+  for (int i = 0; i < ntc; i++) {
+    for (int k = 0; k < D; k++) {
+      int lo = idx_gen();
+      int hi = idx_gen();
+      if (lo > hi) {
+        std::swap(lo, hi);
+      }
+      los[i][k] = lo;
+      his[i][k] = hi;
+    }
+  }
+  // Do the queries.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->range_sum(los[tc], his[tc]));
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+template <int D>
+absl::Duration measure_update(FenwickND<D, int64_t>* ft, int ntc,
+                              std::function<int()> idx_gen,
+                              std::function<int()> val_gen) {
+  // Generate.
+  std::vector<std::array<int, D>> idxs(ntc);
+  std::vector<int64_t> vals;
+  for (auto& idx : idxs) {
+    for (int& i : idx) {
+      i = idx_gen();
+    }
+    vals.push_back(val_gen());
+  }
+  // Do the updates.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    ft->update(idxs[tc], vals[tc]);
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr int64_t kMaxVal = 1000;
+// Orders are per dimension, so the storage is 2^(D * order) nodes.
+constexpr int kMinOrder3D = 3;
+constexpr int kMaxOrder3D = 8;
+constexpr int kMinOrder4D = 2;
+constexpr int kMaxOrder4D = 6;
+const std::unordered_map<int, int> kNumEachPerOrder {
+  { 2, 10000}, { 3, 10000}, { 4, 10000}, { 5, 10000}, { 6,  1000},
+  { 7,  1000}, { 8,  1000}, { 9,   500}, {10,   100},
+};
+
+#define PLOT_DUMP
+
+template <int D>
+void run(std::mt19937& prng, int min_order, int max_order) {
+  std::uniform_int_distribution<int64_t> elem_dist(0, kMaxVal);
+  auto val_gen = [&]() { return elem_dist(prng); };
+
+  for (int order = min_order; order <= max_order; order++) {
+    #ifndef PLOT_DUMP
+      printf("Dimensions: %d Order: %d\n", D, order);
+    #else
+      printf("%d\t%d\t", D, order);
+    #endif
+    auto* ft = FenwickND<D, int64_t>::allocate(order);
+    int n = (1 << order) - 1;
+    std::uniform_int_distribution<int> idx_dist(1, n);
+    auto idx_gen = [&]() { return idx_dist(prng); };
+    const int kNumEach = kNumEachPerOrder.at(order);
+    // 1) Prefix Sum
+    {
+      auto duration = measure_prefix_sum<D>(ft, kNumEach, idx_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x prefix_sum: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    // 2) Update
+    {
+      auto duration = measure_update<D>(ft, kNumEach, idx_gen, val_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x update: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    // 3) Range Sum
+    {
+      auto duration = measure_range_sum<D>(ft, kNumEach, idx_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x range_sum: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    free(ft);
+    printf("\n");
+  }
+}
+
+int main() {
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  run<3>(prng, kMinOrder3D, kMaxOrder3D);
+  run<4>(prng, kMinOrder4D, kMaxOrder4D);
+  return 0;
+}
@@ -0,0 +1,135 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "fenwick_nd.h"
+
+using fenwick::FenwickND;
+
+constexpr int kNumTestCases = 100;
+constexpr int kNumSessions = 20;
+constexpr int kQueriesPerSession = 10;
+constexpr int kUpdatesPerSession = 10;
+
+constexpr int kMaxVal = 1000;
+
+// Offset of idx in a flat (n + 1) x ... x (n + 1) array.
+template <int D>
+size_t offset(const std::array<int, D>& idx, int n) {
+  size_t off = 0;
+  for (int k = 0; k < D; k++) {
+    off = off * (n + 1) + idx[k];
+  }
+  return off;
+}
+
+// Sums a[lo[0]:hi[0]]...[lo[D-1]:hi[D-1]] cell by cell.
+template <int D>
+int64_t box_sum(const std::vector<int64_t>& a, int n,
+                const std::array<int, D>& lo, const std::array<int, D>& hi) {
+  int64_t sum = 0;
+  std::array<int, D> idx = lo;
+  while (true) {
+    sum += a[offset<D>(idx, n)];
+    int k = D - 1;
+    while (k >= 0 && idx[k] == hi[k]) {
+      idx[k] = lo[k];
+      k--;
+    }
+    if (k < 0) {
+      return sum;
+    }
+    idx[k]++;
+  }
+}
+
+// Runs random mixed updates, prefix sums and range sums against
+// FenwickND<D, int64_t> of orders 1..max_order and checks them against sums
+// over a plain array.
+template <int D>
+void test(std::mt19937& prng, int max_order) {
+  std::uniform_int_distribution<int> mgen(1, max_order);
+  std::uniform_int_distribution<int64_t> vgen(-kMaxVal, kMaxVal);
+
+  for (int tc = 1; tc <= kNumTestCases; tc++) {
+    int m = mgen(prng);
+    auto* ft = FenwickND<D, int64_t>::allocate(m);
+    int n = ft->n;
+    assert(n == (1 << m) - 1);
+    std::uniform_int_distribution<int> igen(1, n);
+    auto index_gen = [&]() {
+      std::array<int, D> idx;
+      for (int& i : idx) {
+        i = igen(prng);
+      }
+      return idx;
+    };
+    std::vector<int64_t> a(FenwickND<D, int64_t>::storage_size(n), 0);
+    std::array<int, D> ones;
+    ones.fill(1);
+    // Every other test case starts from a cleared, previously used tree.
+    if (tc % 2 == 0) {
+      for (int u = 0; u < kUpdatesPerSession; u++) {
+        ft->update(index_gen(), vgen(prng));
+      }
+      ft->clear();
+    }
+    for (int s = 0; s < kNumSessions; s++) {
+      for (int u = 0; u < kUpdatesPerSession; u++) {
+        auto idx = index_gen();
+        int64_t delta = vgen(prng);
+        ft->update(idx, delta);
+        a[offset<D>(idx, n)] += delta;
+      }
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        auto idx = index_gen();
+        assert(ft->prefix_sum(idx) == box_sum<D>(a, n, ones, idx));
+        auto lo = index_gen();
+        auto hi = index_gen();
+        for (int k = 0; k < D; k++) {
+          if (lo[k] > hi[k]) {
+            std::swap(lo[k], hi[k]);
+          }
+        }
+        assert(ft->range_sum(lo, hi) == box_sum<D>(a, n, lo, hi));
+      }
+    }
+    free(ft);
+  }
+}
+
+int main() {
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  test<1>(prng, 10);
+  test<2>(prng, 6);
+  test<3>(prng, 4);
+  printf("Success!\n");
+  return 0;
+}
@@ -22,102 +22,350 @@
 #define FENWICK_RMQ_H_
 
 #include <algorithm>
-#include <climits>
+#include <cstddef>
+#include <limits>
 #include <vector>
 
 namespace fenwick {
 namespace rmq {
 
+// Operators the structure can be instantiated with. They have to be
+// associative, commutative and idempotent. Selective operators always return
+// one of their arguments, which lets update skip rebuilding most nodes.
+template <typename T>
+struct Min {
+  static constexpr bool kSelective = true;
+  T operator()(const T& x, const T& y) const { return std::min(x, y); }
+};
+template <typename T>
+struct Max {
+  static constexpr bool kSelective = true;
+  T operator()(const T& x, const T& y) const { return std::max(x, y); }
+};
+template <typename T>
+struct Gcd {
+  static constexpr bool kSelective = false;
+  T operator()(T x, T y) const {
+    while (y != 0) {
+      T t = x % y;
+      x = y;
+      y = t;
+    }
+    return x < 0 ? -x : x;
+  }
+};
+template <typename T>
+struct BitAnd {
+  static constexpr bool kSelective = false;
+  T operator()(const T& x, const T& y) const { return x & y; }
+};
+template <typename T>
+struct BitOr {
+  static constexpr bool kSelective = false;
+  T operator()(const T& x, const T& y) const { return x | y; }
+};
+
+// Identity elements for the operators above.
+// Identity for Min.
+template <typename T>
+struct MaxValue {
+  T operator()() const { return std::numeric_limits<T>::max(); }
+};
+// Identity for Max.
+template <typename T>
+struct MinValue {
+  T operator()() const { return std::numeric_limits<T>::lowest(); }
+};
+// Identity for Gcd and BitOr.
+template <typename T>
+struct Zero {
+  T operator()() const { return T(0); }
+};
+// Identity for BitAnd.
+template <typename T>
+struct AllOnes {
+  T operator()() const { return ~T(0); }
+};
+
+// Storage layouts of the structure. Both expose a(i), lbit(i) and rbit(i) for
+// 0 <= i <= n, and storage_bytes(n), the bytes of the storage for size n.
+//
+// Keeps the array and the two trees in three separate vectors.
+template <typename T>
+struct SeparateLayout {
+  SeparateLayout(int n, const T& init)
+      : as(n + 1, init), lbits(n + 1, init), rbits(n + 1, init) {}
+
+  static size_t storage_bytes(int n) {
+    return 3 * (static_cast<size_t>(n) + 1) * sizeof(T);
+  }
+
+  T& a(int i) { return as[i]; }
+  const T& a(int i) const { return as[i]; }
+  T& lbit(int i) { return lbits[i]; }
+  const T& lbit(int i) const { return lbits[i]; }
+  T& rbit(int i) { return rbits[i]; }
+  const T& rbit(int i) const { return rbits[i]; }
+
+  // The array in question. Kept up-to-date.
+  std::vector<T> as;
+  // Refular Fenwick tree.
+  std::vector<T> lbits;
+  // Counter Fenwick tree.
+  std::vector<T> rbits;
+};
+
+// Keeps a[i], lbit[i] and rbit[i] next to each other, padded to four values
+// (16 bytes for int), so that every step of an update climb touches a single
+// cache line instead of three.
+template <typename T>
+struct InterleavedLayout {
+  struct Node {
+    T a;
+    T lbit;
+    T rbit;
+    T pad;
+  };
+
+  InterleavedLayout(int n, const T& init)
+      : nodes(n + 1, Node{init, init, init, init}) {}
+
+  static size_t storage_bytes(int n) {
+    return (static_cast<size_t>(n) + 1) * sizeof(Node);
+  }
+
+  T& a(int i) { return nodes[i].a; }
+  const T& a(int i) const { return nodes[i].a; }
+  T& lbit(int i) { return nodes[i].lbit; }
+  const T& lbit(int i) const { return nodes[i].lbit; }
+  T& rbit(int i) { return nodes[i].rbit; }
+  const T& rbit(int i) const { return nodes[i].rbit; }
+
+  // The array in question and both trees, interleaved.
+  std::vector<Node> nodes;
+};
+
 // Implements a structure consisting of a Fenwick tree, a counter Fenwick tree
-// and an up-to-date array to solve the Dymanic RMQ problem.
-struct FenwickRMQ {
-  explicit FenwickRMQ(int n)
-      : n(n), a(n + 1, INT_MAX), lbit(n + 1, INT_MAX), rbit(n + 1, INT_MAX) {}
-  // Returns minimum value among a[from], ... , a[to].
+// and an up-to-date array to solve the Dymanic RMQ problem. By default it
+// answers range minimum over int, but any idempotent operator Op over T, with
+// Identity()() as it's identity element, works, e.g.
+// FenwickRMQ<int64_t, Max<int64_t>, MinValue<int64_t>> for range maximum.
+// Layout picks how the array and the trees are stored, see above.
+template <typename T = int, typename Op = Min<T>,
+          typename Identity = MaxValue<T>,
+          template <typename> class Layout = SeparateLayout>
+struct FenwickRMQ : public Layout<T> {
+  using Layout<T>::a;
+  using Layout<T>::lbit;
+  using Layout<T>::rbit;
+
+  explicit FenwickRMQ(int n) : Layout<T>(n, Identity()()), n(n) {}
+
+  // Returns the number of bytes FenwickRMQ(n) takes, the storage included.
+  static size_t memory_bytes(int n) {
+    return sizeof(FenwickRMQ) + Layout<T>::storage_bytes(n);
+  }
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const { return memory_bytes(n); }
+
+  // Constructs the structure from an array of the same size, n.
+  // Complexity: O(n)
+  void construct(const T* values) {
+    Op op;
+    for (int i = 1; i <= n; i++) {
+      a(i) = values[i];
+      lbit(i) = values[i];
+      rbit(i) = values[i];
+    }
+    // Every node pushes it's value into it's parent, which comes after it in
+    // lbit and before it in rbit.
+    for (int i = 1; i <= n; i++) {
+      int p = i + (i & -i);
+      if (p <= n) {
+        lbit(p) = op(lbit(p), lbit(i));
+      }
+    }
+    for (int i = n; i >= 1; i--) {
+      int p = i - (i & -i);
+      if (p >= 1) {
+        rbit(p) = op(rbit(p), rbit(i));
+      }
+    }
+  }
+  // Returns Op over a[from], ... , a[to], e.g. the minimum value.
   // Complexity: O(log n)
   // Assumes that: 1 <= from <= to <= n.
-  int query(int from, int to) {
-    if (from < 1) return INT_MAX;
-    if (to > n) return INT_MAX;
-    if (from > to) return INT_MAX;
+  T query(int from, int to) const {
+    Op op;
+    if (from < 1) return Identity()();
+    if (to > n) return Identity()();
+    if (from > to) return Identity()();
 
-    int res = INT_MAX;
+    T res = Identity()();
 
     // Climb rbit.
     int i = from;
     int ii = i + (i & -i);
     while (i <= n && ii - 1 <= to) {
-      res = std::min(res, rbit[i]);
+      res = op(res, rbit(i));
       i = ii;
       ii = i + (i & -i);
     }
-    if (i <= to) res = std::min(res, a[i]);
+    if (i <= to) res = op(res, a(i));
 
     // Climb lbit.
     i = to;
     ii = i - (i & -i);
     while (i >= 1 && ii + 1 >= from) {
-      res = std::min(res, lbit[i]);
+      res = op(res, lbit(i));
       i = ii;
       ii = i - (i & -i);
     }
-    if (i >= from) res = std::min(res, a[i]);
+    if (i >= from) res = op(res, a(i));
 
     return res;
   }
+  // Answers count queries at once, res[k] = query(from[k], to[k]), in the
+  // given order. A query starting at the same from as the previous one, and
+  // ending no earlier, picks up the previous rbit climb where it stopped. One
+  // ending at the same to, and starting no later, does the same with the lbit
+  // climb. So batches grouped by an endpoint, e.g. windows of growing length
+  // ending at the same index, skip most of the climbing. Once the structure
+  // falls out of the caches the first nodes of the upcoming queries are
+  // prefetched as well.
+  // Complexity: O(count log n), less for the grouped batches.
+  void query_batch(int count, const int* from, const int* to, T* res) const {
+    Op op;
+    const bool prefetch = memory_bytes() > kPrefetchMinBytes;
+    // The last rbit climb: started at rfrom, extended up to rto, stopped at i.
+    int rfrom = 0;
+    int rto = 0;
+    int i = 0;
+    int ii = 0;
+    T rres = Identity()();
+    // The last lbit climb: started at lto, extended down to lfrom, stopped at
+    // j.
+    int lto = 0;
+    int lfrom = 0;
+    int j = 0;
+    int jj = 0;
+    T lres = Identity()();
+    for (int k = 0; k < count; k++) {
+      if (prefetch && k + kPrefetchDistance < count) {
+        int f = from[k + kPrefetchDistance];
+        int t = to[k + kPrefetchDistance];
+        if (f >= 1 && t <= n && f <= t) {
+          __builtin_prefetch(&rbit(f));
+          __builtin_prefetch(&lbit(t));
+        }
+      }
+      if (from[k] < 1 || to[k] > n || from[k] > to[k]) {
+        res[k] = Identity()();
+        continue;
+      }
+      // Climb rbit.
+      if (from[k] != rfrom || to[k] < rto) {
+        rfrom = from[k];
+        i = rfrom;
+        ii = i + (i & -i);
+        rres = Identity()();
+      }
+      rto = to[k];
+      while (i <= n && ii - 1 <= rto) {
+        rres = op(rres, rbit(i));
+        i = ii;
+        ii = i + (i & -i);
+      }
+      T qres = rres;
+      if (i <= rto) qres = op(qres, a(i));
+
+      // Climb lbit.
+      if (to[k] != lto || from[k] > lfrom) {
+        lto = to[k];
+        j = lto;
+        jj = j - (j & -j);
+        lres = Identity()();
+      }
+      lfrom = from[k];
+      while (j >= 1 && jj + 1 >= lfrom) {
+        lres = op(lres, lbit(j));
+        j = jj;
+        jj = j - (j & -j);
+      }
+      qres = op(qres, lres);
+      if (j >= lfrom) qres = op(qres, a(j));
+
+      res[k] = qres;
+    }
+  }
+  // Returns the leftmost index of the value query(from, to) returns, e.g. the
+  // position of the minimum. Returns 0 if the range is invalid.
+  // Complexity: O(log^2 n) worst, without any additional memory.
+  // Assumes that: 1 <= from <= to <= n.
+  // Note: This only works for selective operators, like Min and Max!
+  int query_index(int from, int to) const {
+    static_assert(Op::kSelective,
+                  "query_index needs an operator returning one of it's "
+                  "arguments.");
+    if (from < 1) return 0;
+    if (to > n) return 0;
+    if (from > to) return 0;
+
+    T res = query(from, to);
+
+    // Visit the nodes of the query cover from left to right and descend into
+    // the first one holding res. Climb rbit first, it starts at from.
+    int i = from;
+    int ii = i + (i & -i);
+    while (i <= n && ii - 1 <= to) {
+      if (rbit(i) == res) return rbit_leftmost(i, res);
+      i = ii;
+      ii = i + (i & -i);
+    }
+    if (i <= to && a(i) == res) return i;
+
+    // The lbit climb visits it's nodes from right to left, so they are
+    // collected first.
+    int cover[sizeof(int) * 8];
+    int cover_size = 0;
+    i = to;
+    ii = i - (i & -i);
+    while (i >= 1 && ii + 1 >= from) {
+      cover[cover_size++] = i;
+      i = ii;
+      ii = i - (i & -i);
+    }
+    if (i >= from && a(i) == res) return i;
+    while (cover_size > 0) {
+      int node = cover[--cover_size];
+      if (lbit(node) == res) return lbit_leftmost(node, res);
+    }
+    // Unreachable, res is always held by a node of the cover.
+    return 0;
+  }
   // Sets a[idx] to val.
   // Complexity: O(log n)
   // Assumes that: 1 <= idx <= n.
-  void update(int idx, int val) {
-    if (a[idx] == val) return;
+  void update(int idx, T val) {
+    Op op;
+    if (a(idx) == val) return;
 
     int l, r; /* [l, r] - resp. range of the current node */
-    int ll, lr, lmin; /* range (ll, lr] of the current node in the left side
-                         (..., idx-1] climb and left side min built so far. */
-    int rl, rr, rmin; /* range [rl, rr) of the current node in the left side
-                         [idx+1, ...) climb and right side min built so far. */
-
-    #define SIDES_INIT {                                                       \
-      lr = idx - 1;                                                            \
-      ll = lr - (lr & -lr);                                                    \
-      lmin = INT_MAX;                                                          \
-      rl = idx + 1;                                                            \
-      rr = rl + (rl & -rl);                                                    \
-      rmin = INT_MAX;                                                          \
-    }
-
-    #define SIDES_UPDATE {                                                     \
-      while (lr >= 1 && ll + 1 >= l) {                                         \
-        lmin = std::min(lmin, lbit[lr]);                                       \
-        lr = ll;                                                               \
-        ll = lr - (lr & -lr);                                                  \
-      }                                                                        \
-      if (lr >= l) {                                                           \
-        lmin = std::min(lmin, a[lr]);                                          \
-      }                                                                        \
-      while (rl <= n && rr - 1 <= r) {                                         \
-        rmin = std::min(rmin, rbit[rl]);                                       \
-        rl = rr;                                                               \
-        rr = rl + (rl & -rl);                                                  \
-      }                                                                        \
-      if (rl <= std::min(n, r)) {                                              \
-        rmin = std::min(rmin, a[rl]);                                          \
-      }                                                                        \
-    }
+    Sides sides;
 
     // Update lbit.
     r = idx;
     l = r - (r & -r) + 1;
-    SIDES_INIT;
+    sides_init(idx, idx, &sides);
     while (r <= n) {
-      if (val <= lbit[r]) {
-        // If the new value is less or equeal to the previous node min, use the
-        // new value.
-        lbit[r] = val;
-      } else if (lbit[r] == a[idx]) {
-        SIDES_UPDATE;
+      if (Op::kSelective && op(val, lbit(r)) == val) {
+        // If the new value wins against the previous node value, use the new
+        // value.
+        lbit(r) = val;
+      } else if (!Op::kSelective || lbit(r) == a(idx)) {
+        sides_update(l, r, &sides);
         // Update lbit node.
-        lbit[r] = std::min(val, std::min(lmin, rmin));
+        lbit(r) = op(op(sides.lval, val), sides.rval);
       }
       // Advance lbit.
       r = r + (r & -r);
@@ -126,33 +374,169 @@ struct FenwickRMQ {
     // Update rbit.
     l = idx;
     r = l + (l & -l) - 1;
-    SIDES_INIT;
+    sides_init(idx, idx, &sides);
     while (l >= 1) {
-      if (val <= rbit[l]) {
-        // If the new value is less or equeal to the previous node min, use the
-        // new value.
-        rbit[l] = val;
-      } else if (rbit[l] == a[idx]) {
-        SIDES_UPDATE;
+      if (Op::kSelective && op(val, rbit(l)) == val) {
+        // If the new value wins against the previous node value, use the new
+        // value.
+        rbit(l) = val;
+      } else if (!Op::kSelective || rbit(l) == a(idx)) {
+        sides_update(l, r, &sides);
         // Update rbit node.
-        rbit[l] = std::min(val, std::min(lmin, rmin));
+        rbit(l) = op(op(sides.lval, val), sides.rval);
       }
       // Advance rbit.
       l = l - (l & -l);
       r = l + (l & -l) - 1;
     }
     // Update the array.
-    a[idx] = val;
+    a(idx) = val;
+  }
+
+  // Sets all a[x] where l <= x <= r to val.
+  // Complexity: O((r - l) + log n)
+  // Assumes that: 1 <= l <= r <= n.
+  void range_assign(int l, int r, T val) {
+    for (int i = l; i <= r; i++) {
+      a(i) = val;
+    }
+    rebuild(l, r);
+  }
+  // Adds delta to all a[x] where l <= x <= r. Slots holding the identity, e.g.
+  // the ones never set since the construction, count as cleared and stay so,
+  // adding to INT_MAX of Min<int> would overflow.
+  // Complexity: O((r - l) + log n)
+  // Assumes that: 1 <= l <= r <= n.
+  void range_add(int l, int r, T delta) {
+    const T identity = Identity()();
+    for (int i = l; i <= r; i++) {
+      if (a(i) != identity) {
+        a(i) = a(i) + delta;
+      }
+    }
+    rebuild(l, r);
   }
 
   // Size of the trees and the array.
   int n;
-  // The array in question. Kept up-to-date.
-  std::vector<int> a;
-  // Refular Fenwick tree.
-  std::vector<int> lbit;
-  // Counter Fenwick tree.
-  std::vector<int> rbit;
+
+ private:
+  // How many queries ahead query_batch prefetches.
+  static constexpr int kPrefetchDistance = 8;
+  // Below this footprint the structure stays in the caches, and query_batch
+  // does not prefetch.
+  static constexpr size_t kPrefetchMinBytes = 1 << 20;
+
+  // State of the two climbs around idx, used to rebuild the nodes covering
+  // idx during an update. Both climbs only move outwards as the nodes grow, so
+  // all the rebuilds of one update share them.
+  struct Sides {
+    int ll, lr;  // range (ll, lr] of the current node in the left side
+                 // (..., idx-1] climb
+    T lval;      // and left side value built so far.
+    int rl, rr;  // range [rl, rr) of the current node in the right side
+                 // [idx+1, ...) climb
+    T rval;      // and right side value built so far.
+  };
+
+  // Rebuilds all the lbit and rbit nodes covering any of a[l], ..., a[r] after
+  // those have been changed.
+  // Complexity: O((r - l) + log n)
+  void rebuild(int l, int r) {
+    Op op;
+    // The nodes inside [l, r], from their children. The children of lbit[j]
+    // are lbit[j - 1], lbit[j - 2], ..., and of rbit[i] are rbit[i + 1],
+    // rbit[i + 2], ..., so each tree is rebuilt in the order of it's climbs.
+    // Node j has log(j & -j) children, which is O(1) on average.
+    for (int j = l; j <= r; j++) {
+      T val = a(j);
+      for (int h = 1; h < (j & -j); h <<= 1) {
+        val = op(val, lbit(j - h));
+      }
+      lbit(j) = val;
+    }
+    for (int i = r; i >= l; i--) {
+      T val = a(i);
+      for (int h = 1; h < (i & -i) && i + h <= n; h <<= 1) {
+        val = op(val, rbit(i + h));
+      }
+      rbit(i) = val;
+    }
+    // The lbit nodes above r and the rbit nodes below l cover the range only
+    // partially. Rebuild them like update does, with the side climbs started
+    // at the range edges.
+    Sides sides;
+    sides_init(r + 1, r, &sides);
+    for (int j = r + (r & -r); j <= n; j += j & -j) {
+      sides_update(j - (j & -j) + 1, j, &sides);
+      lbit(j) = op(sides.lval, sides.rval);
+    }
+    sides_init(l, l - 1, &sides);
+    for (int i = l - (l & -l); i >= 1; i -= i & -i) {
+      sides_update(i, i + (i & -i) - 1, &sides);
+      rbit(i) = op(sides.lval, sides.rval);
+    }
+  }
+
+  // Returns the leftmost index in the range of rbit node i holding val.
+  // rbit[i] covers a[i] and the rbit nodes i + 1, i + 2, i + 4, ..., in that
+  // order.
+  // Assumes that: rbit[i] == val.
+  int rbit_leftmost(int i, const T& val) const {
+    while (a(i) != val) {
+      int h = 1;
+      while (i + h <= n && rbit(i + h) != val) {
+        h <<= 1;
+      }
+      i += h;
+    }
+    return i;
+  }
+
+  // Returns the leftmost index in the range of lbit node i holding val.
+  // lbit[i] covers the lbit nodes i - (i & -i) / 2, ..., i - 2, i - 1 and
+  // a[i], in that order.
+  // Assumes that: lbit[i] == val.
+  int lbit_leftmost(int i, const T& val) const {
+    for (int h = (i & -i) >> 1; h >= 1; h >>= 1) {
+      if (lbit(i - h) == val) {
+        i -= h;
+        h = (i & -i);
+      }
+    }
+    return i;
+  }
+
+  // Starts the climbs left of lo and right of hi.
+  static void sides_init(int lo, int hi, Sides* s) {
+    s->lr = lo - 1;
+    s->ll = s->lr - (s->lr & -s->lr);
+    s->lval = Identity()();
+    s->rl = hi + 1;
+    s->rr = s->rl + (s->rl & -s->rl);
+    s->rval = Identity()();
+  }
+
+  // Extends the side climbs to cover [l, idx-1] and [idx+1, r].
+  void sides_update(int l, int r, Sides* s) const {
+    Op op;
+    while (s->lr >= 1 && s->ll + 1 >= l) {
+      s->lval = op(s->lval, lbit(s->lr));
+      s->lr = s->ll;
+      s->ll = s->lr - (s->lr & -s->lr);
+    }
+    if (s->lr >= l) {
+      s->lval = op(s->lval, a(s->lr));
+    }
+    while (s->rl <= n && s->rr - 1 <= r) {
+      s->rval = op(s->rval, rbit(s->rl));
+      s->rl = s->rr;
+      s->rr = s->rl + (s->rl & -s->rl);
+    }
+    if (s->rl <= std::min(n, r)) {
+      s->rval = op(s->rval, a(s->rl));
+    }
+  }
 };
 
 }  // namespace rmq
@@ -18,21 +18,55 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <random>
+#include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 #include "absl/strings/substitute.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
+#include "benchmark_baselines.h"
+#include "benchmark_bytes.h"
+#include "benchmark_cache.h"
+#include "benchmark_latency.h"
+#include "benchmark_index_gen.h"
+#include "benchmark_perf.h"
 #include "fenwick_rmq.h"
 
+using fenwick::bench::CacheSamples;
+using fenwick::bench::LatencyHistogram;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::MinSegmentTree;
+using fenwick::bench::PerfCounters;
+using fenwick::bench::print_bytes;
+using fenwick::bench::print_counters;
+using fenwick::bench::print_memory;
+using fenwick::bench::SparseTable;
+using fenwick::bench::down_walk;
+using fenwick::bench::keep;
+using fenwick::bench::sample_cache_modes;
+using fenwick::bench::sample_latencies;
+using fenwick::bench::touch;
+using fenwick::bench::up_walk;
 using fenwick::rmq::FenwickRMQ;
+using fenwick::rmq::InterleavedLayout;
+using fenwick::rmq::MaxValue;
+using fenwick::rmq::Min;
+using fenwick::rmq::SeparateLayout;
 
 constexpr int kMaxVal = 1 << 30;
 constexpr int kMinOrder = 7;
 constexpr int kMaxOrder = 27;
+// The interleaved layout only pays off once the trees fall out of the caches.
+constexpr int kMinInterleavedOrder = 20;
+// The sparse table takes O(n log n) memory, 2^27 * 28 ints would not fit.
+constexpr int kMaxSparseTableOrder = 22;
 const std::unordered_map<int, int> kNumEachPerOrder {
   { 7, 10000}, { 8, 10000}, { 9, 10000}, {10, 10000}, {11, 10000}, {12,  1000},
   {13,  1000}, {14,  1000}, {15,  1000}, {16,  1000}, {17,   800}, {18,   500},
@@ -41,25 +75,202 @@ const std::unordered_map<int, int> kNumEachPerOrder {
 };
 
 #define PLOT_DUMP
+#ifdef PLOT_DUMP
+  constexpr bool kPlotDump = true;
+#else
+  constexpr bool kPlotDump = false;
+#endif
 
-int main() {
-  std::random_device rd;
-  std::mt19937 prng(rd());
+// Count hardware events (see benchmark_perf.h) around each measured loop and
+// report them per operation.
+// #define PERF_COUNTERS
+#ifdef PERF_COUNTERS
+  constexpr bool kPerfCounters = true;
+#else
+  constexpr bool kPerfCounters = false;
+#endif
+
+// Besides the mean, time each update and query separately and report
+// percentiles.
+// #define LATENCY
+#ifdef LATENCY
+  constexpr bool kLatency = true;
+#else
+  constexpr bool kLatency = false;
+#endif
+// Time every kLatencyPeriod-th operation, in a pass of it's own after the mean
+// loop. The calls in between run untimed, so the fences around the timed ones
+// barely disturb the pipeline.
+constexpr int kLatencyPeriod = 16;
+
+// Report the memory footprint of every order, and the bytes the operations
+// touch (see benchmark_bytes.h) together with the bandwidth that amounts to. A
+// construction is counted as reading the values and writing the whole
+// structure once, a lower bound.
+// #define BYTES
+#ifdef BYTES
+  constexpr bool kBytes = true;
+#else
+  constexpr bool kBytes = false;
+#endif
+
+// Bytes update(idx, ...) and query(from, to) touch, per structure. A FenwickRMQ
+// update climbs lbit up and rbit down from idx and writes a(idx). The nodes
+// that have to be rebuilt from their sides read more, depending on the values,
+// which is left out. A query climbs rbit up from from and lbit down from to,
+// each until the next node would leave the range, and reads at most one a(i)
+// after each climb.
+template <template <typename> class Layout>
+int64_t update_bytes(
+    const FenwickRMQ<int, Min<int>, MaxValue<int>, Layout>& rmq, int idx) {
+  return (up_walk(idx, rmq.n) + down_walk(idx) + 1) * sizeof(int);
+}
+template <template <typename> class Layout>
+int64_t query_bytes(const FenwickRMQ<int, Min<int>, MaxValue<int>, Layout>& rmq,
+                    int from, int to) {
+  int nodes = 0;
+  int i = from;
+  for (; i <= rmq.n && i + (i & -i) - 1 <= to; i += i & -i) {
+    nodes++;
+  }
+  nodes += i <= to;
+  for (i = to; i >= 1 && i - (i & -i) + 1 >= from; i -= i & -i) {
+    nodes++;
+  }
+  nodes += i >= from;
+  return nodes * sizeof(int);
+}
+int64_t query_bytes(const SparseTable&, int, int) { return 2 * sizeof(int); }
+int64_t update_bytes(const MinSegmentTree& st, int) {
+  int nodes = 0;
+  for (int p = st.size; p >= 1; p >>= 1) {
+    nodes++;
+  }
+  return nodes * sizeof(int);
+}
+int64_t query_bytes(const MinSegmentTree& st, int from, int to) {
+  int nodes = 0;
+  for (int lo = from - 1 + st.size, hi = to + st.size; lo < hi;
+       lo >>= 1, hi >>= 1) {
+    nodes += (lo & 1) + (hi & 1);
+    lo += lo & 1;
+    hi -= hi & 1;
+  }
+  return nodes * sizeof(int);
+}
+
+// Time a sample of the updates and queries one by one with the caches flushed
+// (cold) and with the structure read in beforehand (warm), see
+// benchmark_cache.h.
+// #define CACHE_MODES
+#ifdef CACHE_MODES
+  constexpr bool kCacheModes = true;
+#else
+  constexpr bool kCacheModes = false;
+#endif
+// Every cold operation streams through the flush buffer, so only the first
+// kCacheSamples operations are timed.
+constexpr int kCacheSamples = 100;
+
+// Brings the whole structure into the caches. FenwickRMQ is warmed through
+// its layout.
+void warm(const SeparateLayout<int>& rmq) {
+  touch(rmq.as.data(), rmq.as.size() * sizeof(int));
+  touch(rmq.lbits.data(), rmq.lbits.size() * sizeof(int));
+  touch(rmq.rbits.data(), rmq.rbits.size() * sizeof(int));
+}
+void warm(const InterleavedLayout<int>& rmq) {
+  touch(rmq.nodes.data(),
+        rmq.nodes.size() * sizeof(InterleavedLayout<int>::Node));
+}
+void warm(const SparseTable& st) {
+  for (const auto& row : st.table) {
+    touch(row.data(), row.size() * sizeof(int));
+  }
+}
+void warm(const MinSegmentTree& st) {
+  touch(st.t.data(), st.t.size() * sizeof(int));
+}
+
+// Prints the mean and the median latency of the warm and the cold samples,
+// side by side.
+void print_cache(const CacheSamples& cache) {
+  if (!kCacheModes) {
+    return;
+  }
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "warm mean: $0 p50: $1 cold mean: $2 p50: $3",
+        absl::FormatDuration(absl::Nanoseconds(cache.warm.mean())),
+        absl::FormatDuration(absl::Nanoseconds(cache.warm.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(cache.cold.mean())),
+        absl::FormatDuration(absl::Nanoseconds(cache.cold.percentile(0.5))));
+    printf("    %s\n", msg.c_str());
+  #else
+    printf("%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\t", cache.warm.mean(),
+           cache.warm.percentile(0.5), cache.cold.mean(),
+           cache.cold.percentile(0.5));
+  #endif
+}
+
+void print_latency(const LatencyHistogram& hist) {
+  if (!kLatency) {
+    return;
+  }
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "p50: $0 p99: $1 p999: $2",
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.99))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.999))));
+    printf("    %s\n", msg.c_str());
+  #else
+    printf("%15.3lf\t%15.3lf\t%15.3lf\t", hist.percentile(0.5),
+           hist.percentile(0.99), hist.percentile(0.999));
+  #endif
+}
+
+template <template <typename> class Layout>
+void run(std::mt19937& prng, const IndexPattern& pattern, const char* layout,
+         int min_order, int max_order) {
   std::uniform_int_distribution<int> vgen(0, kMaxVal);
 
-  for (int order = kMinOrder; order <= kMaxOrder; order++) {
+  for (int order = min_order; order <= max_order; order++) {
     #ifndef PLOT_DUMP
-      printf("Order: %d\n", order);
+      printf("Layout: %s Order: %d\n", layout, order);
     #else
-      printf("%d\t", order);
+      printf("%s\t%d\t", layout, order);
     #endif
     int n = (1 << order) - 1;
-    FenwickRMQ rmq(n);
-    std::uniform_int_distribution<int> igen(1, n);
+    FenwickRMQ<int, Min<int>, MaxValue<int>, Layout> rmq(n);
+    print_memory(rmq.memory_bytes(), kBytes, kPlotDump);
+    auto idx_gen = pattern.make(n, &prng);
     const int kNumEach = kNumEachPerOrder.at(order);
-    // Prefil, since it's all lower than INT_MAX, this is a simple case.
-    for (int i = 1; i <= n; i++) {
-      rmq.update(i, vgen(prng));
+    // Measure construction, which also prefils the structure.
+    {
+      // Generate.
+      std::vector<int> vs(n + 1);
+      for (int i = 1; i <= n; i++) {
+        vs[i] = vgen(prng);
+      }
+      // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
+      auto start = absl::Now();
+      rmq.construct(vs.data());
+      auto duration = absl::Now() - start;
+      perf.stop();
+      // Print.
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("1 x construct: $0: ",
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_bytes(1.0 * n * sizeof(int) + rmq.memory_bytes(), duration, kBytes,
+                  kPlotDump);
+      print_counters(perf, 1, kPerfCounters, kPlotDump);
     }
     // Measure updates.
     {
@@ -67,15 +278,18 @@ int main() {
       std::vector<int> is;
       std::vector<int> vs;
       for (int i = 0; i < kNumEach; i++) {
-        is.push_back(igen(prng));
+        is.push_back(idx_gen());
         vs.push_back(vgen(prng));
       }
       // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
       auto start = absl::Now();
       for (int i = 0; i < kNumEach; i++) {
         rmq.update(is[i], vs[i]);
       }
       auto duration = absl::Now() - start;
+      perf.stop();
       // Print.
       duration /= kNumEach;
       #ifndef PLOT_DUMP
@@ -85,6 +299,28 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      if (kBytes) {
+        int64_t bytes = 0;
+        for (int i = 0; i < kNumEach; i++) {
+          bytes += update_bytes(rmq, is[i]);
+        }
+        print_bytes(1.0 * bytes / kNumEach, duration, kBytes, kPlotDump);
+      }
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+      // Latencies, over the same operations.
+      if (kLatency) {
+        LatencyHistogram hist;
+        sample_latencies(kNumEach, kLatencyPeriod, &hist,
+                         [&](int i) { rmq.update(is[i], vs[i]); });
+        print_latency(hist);
+      }
+      if (kCacheModes) {
+        CacheSamples cache;
+        sample_cache_modes(
+            kNumEach, kCacheSamples, [&]() { warm(rmq); }, &cache,
+            [&](int i) { rmq.update(is[i], vs[i]); });
+        print_cache(cache);
+      }
     }
     // Measure queries.
     {
@@ -92,8 +328,8 @@ int main() {
       std::vector<int> ls;
       std::vector<int> rs;
       for (int i = 0; i < kNumEach; i++) {
-        int l = igen(prng);
-        int r = igen(prng);
+        int l = idx_gen();
+        int r = idx_gen();
         if (l > r) {
           std::swap(l, r);
         }
@@ -101,11 +337,14 @@ int main() {
         rs.push_back(r);
       }
       // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
       auto start = absl::Now();
       for (int i = 0; i < kNumEach; i++) {
-        rmq.query(ls[i], rs[i]);
+        keep(rmq.query(ls[i], rs[i]));
       }
       auto duration = absl::Now() - start;
+      perf.stop();
       // Print.
       duration /= kNumEach;
       #ifndef PLOT_DUMP
@@ -115,8 +354,353 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      if (kBytes) {
+        int64_t bytes = 0;
+        for (int i = 0; i < kNumEach; i++) {
+          bytes += query_bytes(rmq, ls[i], rs[i]);
+        }
+        print_bytes(1.0 * bytes / kNumEach, duration, kBytes, kPlotDump);
+      }
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+      // Latencies, over the same operations.
+      if (kLatency) {
+        LatencyHistogram hist;
+        sample_latencies(kNumEach, kLatencyPeriod, &hist,
+                         [&](int i) { return rmq.query(ls[i], rs[i]); });
+        print_latency(hist);
+      }
+      if (kCacheModes) {
+        CacheSamples cache;
+        sample_cache_modes(
+            kNumEach, kCacheSamples, [&]() { warm(rmq); }, &cache,
+            [&](int i) { return rmq.query(ls[i], rs[i]); });
+        print_cache(cache);
+      }
+    }
+    // Measure batched queries.
+    {
+      // Generate.
+      std::vector<int> ls;
+      std::vector<int> rs;
+      for (int i = 0; i < kNumEach; i++) {
+        int l = idx_gen();
+        int r = idx_gen();
+        if (l > r) {
+          std::swap(l, r);
+        }
+        ls.push_back(l);
+        rs.push_back(r);
+      }
+      std::vector<int> res(kNumEach);
+      // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
+      auto start = absl::Now();
+      rmq.query_batch(kNumEach, ls.data(), rs.data(), res.data());
+      auto duration = absl::Now() - start;
+      perf.stop();
+      // Print.
+      duration /= kNumEach;
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x query_batch: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // Measure windows of lengths 1, 2, 4, ... ending at the same index, longest
+    // last, one by one and batched. The batch shares the lbit climb within
+    // every group. Each run gets it's own windows, so that the second does not
+    // find them in the caches.
+    {
+      // Generate.
+      auto windows_gen = [&](std::vector<int>* ls, std::vector<int>* rs) {
+        while (static_cast<int>(ls->size()) < kNumEach) {
+          int r = idx_gen();
+          for (int w = 1; w <= r && static_cast<int>(ls->size()) < kNumEach;
+               w *= 2) {
+            ls->push_back(r - w + 1);
+            rs->push_back(r);
+          }
+        }
+      };
+      std::vector<int> ls;
+      std::vector<int> rs;
+      windows_gen(&ls, &rs);
+      std::vector<int> batch_ls;
+      std::vector<int> batch_rs;
+      windows_gen(&batch_ls, &batch_rs);
+      std::vector<int> res(kNumEach);
+      // Run.
+      auto start = absl::Now();
+      for (int i = 0; i < kNumEach; i++) {
+        keep(rmq.query(ls[i], rs[i]));
+      }
+      auto duration = absl::Now() - start;
+      start = absl::Now();
+      rmq.query_batch(kNumEach, batch_ls.data(), batch_rs.data(), res.data());
+      auto batch_duration = absl::Now() - start;
+      // Print.
+      duration /= kNumEach;
+      batch_duration /= kNumEach;
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute(
+            "$0 x windows: query: $1 query_batch: $2", kNumEach,
+            absl::FormatDuration(duration),
+            absl::FormatDuration(batch_duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t%15.3lf\t", ToDoubleNanoseconds(duration),
+               ToDoubleNanoseconds(batch_duration));
+      #endif
+    }
+    // Measure index queries.
+    {
+      // Generate.
+      std::vector<int> ls;
+      std::vector<int> rs;
+      for (int i = 0; i < kNumEach; i++) {
+        int l = idx_gen();
+        int r = idx_gen();
+        if (l > r) {
+          std::swap(l, r);
+        }
+        ls.push_back(l);
+        rs.push_back(r);
+      }
+      // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
+      auto start = absl::Now();
+      for (int i = 0; i < kNumEach; i++) {
+        keep(rmq.query_index(ls[i], rs[i]));
+      }
+      auto duration = absl::Now() - start;
+      perf.stop();
+      // Print.
+      duration /= kNumEach;
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x query_index: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+      // Latencies, over the same operations.
+      if (kLatency) {
+        LatencyHistogram hist;
+        sample_latencies(kNumEach, kLatencyPeriod, &hist,
+                         [&](int i) { return rmq.query_index(ls[i], rs[i]); });
+        print_latency(hist);
+      }
+      if (kCacheModes) {
+        CacheSamples cache;
+        sample_cache_modes(
+            kNumEach, kCacheSamples, [&]() { warm(rmq); }, &cache,
+            [&](int i) { return rmq.query_index(ls[i], rs[i]); });
+        print_cache(cache);
+      }
     }
     printf("\n");
   }
+}
 
+// Measures kNumEach updates on a reference structure, if it supports them.
+template <typename Tree>
+void measure_reference_update(Tree* tree, std::mt19937& prng,
+                              std::function<int()> idx_gen, int ntc,
+                              std::true_type /* dynamic */) {
+  std::uniform_int_distribution<int> vgen(0, kMaxVal);
+  // Generate.
+  std::vector<int> is;
+  std::vector<int> vs;
+  for (int i = 0; i < ntc; i++) {
+    is.push_back(idx_gen());
+    vs.push_back(vgen(prng));
+  }
+  // Run.
+  PerfCounters perf(kPerfCounters);
+  perf.start();
+  auto start = absl::Now();
+  for (int i = 0; i < ntc; i++) {
+    tree->update(is[i], vs[i]);
+  }
+  auto duration = absl::Now() - start;
+  perf.stop();
+  // Print.
+  duration /= ntc;
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute("$0 x update: $1: ", ntc,
+                                absl::FormatDuration(duration));
+    printf("  %s\n", msg.c_str());
+  #else
+    printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+  #endif
+  if (kBytes) {
+    int64_t bytes = 0;
+    for (int i = 0; i < ntc; i++) {
+      bytes += update_bytes(*tree, is[i]);
+    }
+    print_bytes(1.0 * bytes / ntc, duration, kBytes, kPlotDump);
+  }
+  print_counters(perf, ntc, kPerfCounters, kPlotDump);
+  // Latencies, over the same operations.
+  if (kLatency) {
+    LatencyHistogram hist;
+    sample_latencies(ntc, kLatencyPeriod, &hist,
+                     [&](int i) { tree->update(is[i], vs[i]); });
+    print_latency(hist);
+  }
+  if (kCacheModes) {
+    CacheSamples cache;
+    sample_cache_modes(ntc, kCacheSamples, [&]() { warm(*tree); }, &cache,
+                       [&](int i) { tree->update(is[i], vs[i]); });
+    print_cache(cache);
+  }
+}
+template <typename Tree>
+void measure_reference_update(Tree*, std::mt19937&, std::function<int()>, int,
+                              std::false_type /* dynamic */) {
+  #ifndef PLOT_DUMP
+    printf("  update: static structure\n");
+  #else
+    // A "-" for every column the dynamic overload prints: the mean, the bytes,
+    // the counters, the latency percentiles and the cache modes.
+    int columns = 1 + (kBytes ? 2 : 0) +
+                  (kPerfCounters ? PerfCounters::kNumEvents : 0) +
+                  (kLatency ? 3 : 0) + (kCacheModes ? 4 : 0);
+    for (int c = 0; c < columns; c++) {
+      printf("%15s\t", "-");
+    }
+  #endif
+}
+
+// Runs the construction, update and query measurements on a reference range
+// minimum structure, with the same kind of inputs as FenwickRMQ gets in run.
+// The rows line up with the ones of run, without the batched and the index
+// queries.
+template <typename Tree>
+void run_reference(std::mt19937& prng, const IndexPattern& pattern,
+                   const char* name, int min_order, int max_order) {
+  std::uniform_int_distribution<int> vgen(0, kMaxVal);
+
+  for (int order = min_order; order <= max_order; order++) {
+    #ifndef PLOT_DUMP
+      printf("Reference: %s Order: %d\n", name, order);
+    #else
+      printf("%s\t%d\t", name, order);
+    #endif
+    int n = (1 << order) - 1;
+    Tree tree(n);
+    auto idx_gen = pattern.make(n, &prng);
+    const int kNumEach = kNumEachPerOrder.at(order);
+    // Measure construction.
+    {
+      // Generate.
+      std::vector<int> vs(n + 1);
+      for (int i = 1; i <= n; i++) {
+        vs[i] = vgen(prng);
+      }
+      // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
+      auto start = absl::Now();
+      tree.construct(vs.data());
+      auto duration = absl::Now() - start;
+      perf.stop();
+      // Print.
+      print_memory(tree.memory_bytes(), kBytes, kPlotDump);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("1 x construct: $0: ",
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_bytes(1.0 * n * sizeof(int) + tree.memory_bytes(), duration, kBytes,
+                  kPlotDump);
+      print_counters(perf, 1, kPerfCounters, kPlotDump);
+    }
+    // Measure updates.
+    measure_reference_update(&tree, prng, idx_gen, kNumEach,
+                             std::integral_constant<bool, Tree::kDynamic>());
+    // Measure queries.
+    {
+      // Generate.
+      std::vector<int> ls;
+      std::vector<int> rs;
+      for (int i = 0; i < kNumEach; i++) {
+        int l = idx_gen();
+        int r = idx_gen();
+        if (l > r) {
+          std::swap(l, r);
+        }
+        ls.push_back(l);
+        rs.push_back(r);
+      }
+      // Run.
+      PerfCounters perf(kPerfCounters);
+      perf.start();
+      auto start = absl::Now();
+      for (int i = 0; i < kNumEach; i++) {
+        keep(tree.query(ls[i], rs[i]));
+      }
+      auto duration = absl::Now() - start;
+      perf.stop();
+      // Print.
+      duration /= kNumEach;
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x query: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      if (kBytes) {
+        int64_t bytes = 0;
+        for (int i = 0; i < kNumEach; i++) {
+          bytes += query_bytes(tree, ls[i], rs[i]);
+        }
+        print_bytes(1.0 * bytes / kNumEach, duration, kBytes, kPlotDump);
+      }
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+      // Latencies, over the same operations.
+      if (kLatency) {
+        LatencyHistogram hist;
+        sample_latencies(kNumEach, kLatencyPeriod, &hist,
+                         [&](int i) { return tree.query(ls[i], rs[i]); });
+        print_latency(hist);
+      }
+      if (kCacheModes) {
+        CacheSamples cache;
+        sample_cache_modes(
+            kNumEach, kCacheSamples, [&]() { warm(tree); }, &cache,
+            [&](int i) { return tree.query(ls[i], rs[i]); });
+        print_cache(cache);
+      }
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char** argv) {
+  IndexPattern pattern;
+  if (!IndexPattern::from_args(argc, argv, &pattern)) {
+    fprintf(stderr, "Usage: %s [--pattern=%s]\n", argv[0],
+            IndexPattern::kUsage);
+    return 1;
+  }
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  run<SeparateLayout>(prng, pattern, "separate", kMinOrder, kMaxOrder);
+  run<InterleavedLayout>(prng, pattern, "interleaved", kMinInterleavedOrder,
+                         kMaxOrder);
+  run_reference<SparseTable>(prng, pattern, "sparse_table", kMinOrder,
+                             kMaxSparseTableOrder);
+  run_reference<MinSegmentTree>(prng, pattern, "segment_tree", kMinOrder,
+                                kMaxOrder);
+  return 0;
 }
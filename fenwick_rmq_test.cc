@@ -18,40 +18,87 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstdint>
 #include <cstdio>
+#include <functional>
 #include <random>
+#include <type_traits>
+#include <vector>
 
 #include "fenwick_rmq.h"
+#include "fenwick_rmq_window.h"
 
 using fenwick::rmq::FenwickRMQ;
+using fenwick::rmq::FenwickRMQWindow;
 
 constexpr int kNumTestCases = 1000;
 constexpr int kNumSessions = 100;
 constexpr int kQueriesPerSession = 10;
 constexpr int kUpdatesPerSession = 10;
 
-constexpr int kMaxN = 100000;
+constexpr int kMaxN = 1000;
 constexpr int kMaxVal = 1000;
 
-int main() {
-  std::random_device rd;
-  std::mt19937 prng(rd());
-  std::uniform_int_distribution<int> ngen(1, kNumTestCases);
-  std::uniform_int_distribution<int> vgen(0, kMaxVal);
+// Checks query_index against std::find of the query result over a[l..r], for
+// the selective operators that support it.
+template <typename RMQ>
+void check_index(const RMQ& rmq, int l, int r, std::true_type) {
+  std::vector<decltype(rmq.query(l, r))> values;
+  for (int i = l; i <= r; i++) {
+    values.push_back(rmq.a(i));
+  }
+  int sol = l + (std::find(values.begin(), values.end(), rmq.query(l, r)) -
+                 values.begin());
+  int myres = rmq.query_index(l, r);
+  assert(sol == myres);
+}
+template <typename RMQ>
+void check_index(const RMQ&, int, int, std::false_type) {}
+
+// Runs random mixed updates and queries against
+// FenwickRMQ<T, Op, Identity, Layout> and checks them against a linear fold of
+// the up-to-date array.
+template <typename T, typename Op, typename Identity,
+          template <typename> class Layout = fenwick::rmq::SeparateLayout>
+void test(std::mt19937& prng, std::function<T()> vgen) {
+  std::uniform_int_distribution<int> ngen(1, kMaxN);
 
   for (int tc = 1; tc <= kNumTestCases; tc++) {
     int n = ngen(prng);
-    FenwickRMQ rmq(n);
+    FenwickRMQ<T, Op, Identity, Layout> rmq(n);
     std::uniform_int_distribution<int> igen(1, n);
-    // Prefil, since it's all lower than INT_MAX, this is a simple case.
-    for (int i = 1; i <= n; i++) {
-      rmq.update(i, vgen(prng));
+    // Prefil, since it all differs from the identity, this is a simple case.
+    // Every other test case uses construct instead.
+    if (tc % 2 == 0) {
+      std::vector<T> values(n + 1);
+      for (int i = 1; i <= n; i++) {
+        values[i] = vgen();
+      }
+      rmq.construct(values.data());
+    } else {
+      for (int i = 1; i <= n; i++) {
+        rmq.update(i, vgen());
+      }
     }
     // Do a bunch of queries, mixed.
     for (int s = 0; s < kNumSessions; s++) {
       for (int u = 0; u < kUpdatesPerSession; u++) {
-        rmq.update(igen(prng), vgen(prng));
+        rmq.update(igen(prng), vgen());
+      }
+      {
+        int l = igen(prng);
+        int r = igen(prng);
+        if (l > r) {
+          std::swap(l, r);
+        }
+        if (s % 2 == 0) {
+          rmq.range_assign(l, r, vgen());
+        } else {
+          rmq.range_add(l, r, vgen());
+        }
       }
       for (int q = 0; q < kQueriesPerSession; q++) {
         int l = igen(prng);
@@ -59,12 +106,165 @@ int main() {
         if (l > r) {
           std::swap(l, r);
         }
-        int sol = *std::min_element(rmq.a.begin() + l, rmq.a.begin() + r + 1);
-        int myres = rmq.query(l, r);
+        T sol = Identity()();
+        for (int i = l; i <= r; i++) {
+          sol = Op()(sol, rmq.a(i));
+        }
+        T myres = rmq.query(l, r);
         assert(sol == myres);
+        check_index(rmq, l, r,
+                    std::integral_constant<bool, Op::kSelective>());
+      }
+      // And a batch of queries, in pairs sharing from, some of which end up
+      // invalid with to < from or end before the first one, followed by
+      // groups sharing to, longest last.
+      std::vector<int> ls;
+      std::vector<int> rs;
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        int l = igen(prng);
+        int r = igen(prng);
+        if (l > r) {
+          std::swap(l, r);
+        }
+        ls.push_back(l);
+        rs.push_back(r);
+        ls.push_back(l);
+        rs.push_back(igen(prng));
+      }
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        int r = igen(prng);
+        for (int w = 1; w <= r; w *= 2) {
+          ls.push_back(r - w + 1);
+          rs.push_back(r);
+        }
+      }
+      std::vector<T> batch(ls.size());
+      rmq.query_batch(ls.size(), ls.data(), rs.data(), batch.data());
+      for (size_t q = 0; q < ls.size(); q++) {
+        assert(batch[q] == rmq.query(ls[q], rs[q]));
       }
     }
   }
+}
+
+// Sets a few slots of fresh structures, leaving the rest cleared, and checks
+// range_add over ranges mixing both against a brute force in which the cleared
+// slots stay at the identity.
+template <typename T, typename Op, typename Identity>
+void test_range_add_cleared(std::mt19937& prng, std::function<T()> vgen) {
+  std::uniform_int_distribution<int> ngen(1, kMaxN);
+
+  for (int tc = 1; tc <= kNumTestCases / 10; tc++) {
+    int n = ngen(prng);
+    FenwickRMQ<T, Op, Identity> rmq(n);
+    std::vector<T> values(n + 1, Identity()());
+    std::uniform_int_distribution<int> igen(1, n);
+    for (int u = 0; u < n / 4; u++) {
+      int i = igen(prng);
+      values[i] = vgen();
+      rmq.update(i, values[i]);
+    }
+    for (int s = 0; s < kNumSessions; s++) {
+      int l = igen(prng);
+      int r = igen(prng);
+      if (l > r) {
+        std::swap(l, r);
+      }
+      T delta = vgen();
+      rmq.range_add(l, r, delta);
+      for (int i = l; i <= r; i++) {
+        if (values[i] != Identity()()) {
+          values[i] += delta;
+        }
+      }
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        l = igen(prng);
+        r = igen(prng);
+        if (l > r) {
+          std::swap(l, r);
+        }
+        T sol = Identity()();
+        for (int i = l; i <= r; i++) {
+          assert(rmq.a(i) == values[i]);
+          sol = Op()(sol, values[i]);
+        }
+        assert(sol == rmq.query(l, r));
+      }
+    }
+  }
+}
+
+// Streams samples with random time gaps into a FenwickRMQWindow and checks
+// random sub-window queries against a scan of the kept samples.
+void test_window(std::mt19937& prng) {
+  std::uniform_int_distribution<int> ngen(1, kMaxN);
+  std::uniform_int_distribution<int> vgen(0, kMaxVal);
+  std::uniform_int_distribution<int> gapgen(0, 3);
+
+  for (int tc = 1; tc <= kNumTestCases / 10; tc++) {
+    int n = ngen(prng);
+    FenwickRMQWindow<> window(n);
+    std::vector<int> samples;  // samples[t], INT_MAX if there is none.
+    for (int s = 0; s < kNumSessions; s++) {
+      for (int u = 0; u < kUpdatesPerSession; u++) {
+        // Mostly consecutive samples, sometimes a gap, rarely a long one.
+        int64_t t = window.now + 1 + gapgen(prng);
+        if (gapgen(prng) == 0 && gapgen(prng) == 0) {
+          t += vgen(prng);
+        }
+        int val = vgen(prng);
+        window.push(t, val);
+        samples.resize(t + 1, INT_MAX);
+        samples[t] = val;
+      }
+      std::uniform_int_distribution<int64_t> tgen(window.now - 2 * n,
+                                                  window.now + 1);
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        int64_t from = tgen(prng);
+        int64_t to = tgen(prng);
+        if (from > to) {
+          std::swap(from, to);
+        }
+        int sol = INT_MAX;
+        for (int64_t t = std::max(from, window.now - n + 1);
+             t <= std::min(to, window.now); t++) {
+          if (t >= 0) {
+            sol = std::min(sol, samples[t]);
+          }
+        }
+        assert(sol == window.query(from, to));
+      }
+    }
+  }
+}
+
+int main() {
+  using namespace fenwick::rmq;
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  std::uniform_int_distribution<int> vgen(0, kMaxVal);
+  std::uniform_int_distribution<int64_t> vgen64(-(1LL << 40), 1LL << 40);
+  std::uniform_real_distribution<double> vgend(-1.0, 1.0);
+
+  test<int, Min<int>, MaxValue<int>>(prng, [&]() { return vgen(prng); });
+  test<int64_t, Max<int64_t>, MinValue<int64_t>>(
+      prng, [&]() { return vgen64(prng); });
+  test<double, Min<double>, MaxValue<double>>(
+      prng, [&]() { return vgend(prng); });
+  test<int, Gcd<int>, Zero<int>>(prng, [&]() { return vgen(prng) * 6; });
+  test<unsigned, BitAnd<unsigned>, AllOnes<unsigned>>(
+      prng, [&]() { return ~(1u << (vgen(prng) % 32)); });
+  test<unsigned, BitOr<unsigned>, Zero<unsigned>>(
+      prng, [&]() { return 1u << (vgen(prng) % 32); });
+  test<int, Min<int>, MaxValue<int>, InterleavedLayout>(
+      prng, [&]() { return vgen(prng); });
+  test<int, Gcd<int>, Zero<int>, InterleavedLayout>(
+      prng, [&]() { return vgen(prng) * 6; });
+  test_range_add_cleared<int, Min<int>, MaxValue<int>>(
+      prng, [&]() { return vgen(prng); });
+  test_range_add_cleared<int, Max<int>, MinValue<int>>(
+      prng, [&]() { return -vgen(prng); });
+  test_window(prng);
   printf("Success!\n");
   return 0;
 }
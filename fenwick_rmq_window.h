@@ -0,0 +1,100 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FENWICK_RMQ_WINDOW_H_
+#define FENWICK_RMQ_WINDOW_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "fenwick_rmq.h"
+
+namespace fenwick {
+namespace rmq {
+
+// Implements a sliding window over a stream of samples on top of FenwickRMQ.
+// Samples carry a monotonically increasing time t >= 0 and are kept in the n
+// slots of the structure as a ring buffer, sample t in slot t % n + 1. Any
+// sub-window of the last n time units can be queried.
+template <typename T = int, typename Op = Min<T>,
+          typename Identity = MaxValue<T>,
+          template <typename> class Layout = SeparateLayout>
+struct FenwickRMQWindow {
+  explicit FenwickRMQWindow(int n) : n(n), now(-1), rmq(n) {}
+
+  // Records val as the sample at time t. Times skipped since the last sample
+  // hold no sample, their slots are expired in one go.
+  // Complexity: O(log n + min(n, t - now))
+  // Assumes that: t >= now, the time of the last sample.
+  void push(int64_t t, T val) {
+    if (t > now + 1) {
+      expire(now + 1, t - 1);
+    }
+    rmq.update(slot(t), val);
+    now = t;
+  }
+  // Returns Op over the samples with times in [from, to], e.g. the minimum.
+  // Times outside of the window (now - n, now] are ignored.
+  // Complexity: O(log n)
+  T query(int64_t from, int64_t to) const {
+    from = std::max(from, std::max(now - n + 1, int64_t(0)));
+    to = std::min(to, now);
+    if (from > to) return Identity()();
+    int l = slot(from);
+    int r = slot(to);
+    if (l <= r) return rmq.query(l, r);
+    // The range wraps around the end of the ring.
+    return Op()(rmq.query(l, n), rmq.query(1, r));
+  }
+  // Returns Op over the samples of the last w time units, (now - w, now].
+  // Complexity: O(log n)
+  T last(int w) const { return query(now - w + 1, now); }
+
+  // Number of slots, the longest window.
+  int n;
+  // Time of the last sample, -1 before the first one.
+  int64_t now;
+  // The ring buffer.
+  FenwickRMQ<T, Op, Identity, Layout> rmq;
+
+ private:
+  int slot(int64_t t) const { return static_cast<int>(t % n) + 1; }
+
+  // Clears the slots of all the times in [from, to].
+  void expire(int64_t from, int64_t to) {
+    if (to - from + 1 >= n) {
+      rmq.range_assign(1, n, Identity()());
+      return;
+    }
+    int l = slot(from);
+    int r = slot(to);
+    if (l <= r) {
+      rmq.range_assign(l, r, Identity()());
+    } else {
+      rmq.range_assign(l, n, Identity()());
+      rmq.range_assign(1, r, Identity()());
+    }
+  }
+};
+
+}  // namespace rmq
+}  // namespace fenwick
+
+#endif  // FENWICK_RMQ_WINDOW_H_
@@ -21,45 +21,107 @@
 #ifndef FENWICK_RURQ_H_
 #define FENWICK_RURQ_H_
 
-#include "fenwick.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
 
 namespace fenwick {
 
 // Implements a structure consisting of two Fenwick trees to solve the
 // range-update range-query varioation of the Dynamic Partial Sums problem.
+// The two trees are interleaved in a single array, so that a walk reads both
+// of them at once.
 struct FenwickRURQ {
+  // A node of both trees. Both values always land in the same cache line.
+  struct Node {
+    int64_t t1;
+    int64_t t2;
+  };
+
   // This structure can be normally constructed.
   explicit FenwickRURQ(int m) {
-    T1 = Fenwick::allocate(m);
-    T2 = Fenwick::allocate(m);
-    n = T1->n;
+    n = (1 << m) - 1;
+    T = reinterpret_cast<Node*>(malloc((n + 1) * sizeof(Node)));
+    clear();
   }
 
   // Disable other copying ans assigning.
-  FenwickRURQ(const Fenwick&) = delete;
-  void operator=(const Fenwick&) = delete;
+  FenwickRURQ(const FenwickRURQ&) = delete;
+  void operator=(const FenwickRURQ&) = delete;
+
+  ~FenwickRURQ() { free(T); }
 
-  ~FenwickRURQ() {
-    free(T1);
-    free(T2);
+  // Returns the number of bytes FenwickRURQ(m) takes, the trees included.
+  static size_t memory_bytes(int m) {
+    return sizeof(FenwickRURQ) + (static_cast<size_t>(1) << m) * sizeof(Node);
+  }
+  // Returns the number of bytes this instance takes.
+  size_t memory_bytes() const {
+    return sizeof(FenwickRURQ) + (static_cast<size_t>(n) + 1) * sizeof(Node);
   }
 
+  // Sets all array elements to 0.
+  void clear() { std::fill_n(T, n + 1, Node{0LL, 0LL}); }
+
   // Adds delta to all a[x] where l <= x <= r.
   // Complexity: O(log n)
   // Assumes that: 1 <= l <= r <= n.
   void update(int l, int r, int64_t delta) {
-    T1->update(l, delta);
-    T2->update(l, delta * (l - 1));
-    if (r < n) {
-      T1->update(r + 1, -delta);
-      T2->update(r + 1, -delta * r);
+    int64_t ldelta = delta * (l - 1);
+    int64_t rdelta = -delta * r;
+    // Walk up from l and r + 1, always advancing the lower one, until the two
+    // walks meet or leave the tree.
+    int i = l;
+    int j = r + 1;
+    while (i != j) {
+      if (i < j) {
+        if (i > n) break;
+        T[i].t1 += delta;
+        T[i].t2 += ldelta;
+        i += i & -i;
+      } else {
+        if (j > n) break;
+        T[j].t1 -= delta;
+        T[j].t2 += rdelta;
+        j += j & -j;
+      }
+    }
+    // From the common ancestor on, the two T1 deltas cancel out.
+    if (i == j) {
+      for (; i <= n; i += i & -i) {
+        T[i].t2 += ldelta + rdelta;
+      }
+    }
+  }
+  // Constructs the trees from an array of the same size, n.
+  // Complexity: O(n)
+  void construct(const int64_t* a) {
+    // Fill the nodes with the difference array terms, then push every node
+    // into it's parent, which sums up exactly the covered ranges.
+    T[0] = Node{0LL, 0LL};
+    for (int i = 1; i <= n; i++) {
+      int64_t d = (i == 1) ? a[1] : a[i] - a[i - 1];
+      T[i] = Node{d, d * (i - 1)};
+    }
+    for (int i = 1; i <= n; i++) {
+      int p = i + (i & -i);
+      if (p <= n) {
+        T[p].t1 += T[i].t1;
+        T[p].t2 += T[i].t2;
+      }
     }
   }
   // Returns a[1] + ... + a[idx].
   // Complexity: O(log n)
   // Assumes that: 1 <= idx <= n.
   int64_t prefix_sum(int idx) const {
-    return T1->prefix_sum(idx) * idx - T2->prefix_sum(idx);
+    int64_t sum1 = 0;
+    int64_t sum2 = 0;
+    for (int i = idx; i >= 1; i -= i & -i) {
+      sum1 += T[i].t1;
+      sum2 += T[i].t2;
+    }
+    return sum1 * idx - sum2;
   }
   // Returns a[l] + ... + a[r].
   // Complexity: O(log n)
@@ -71,12 +133,95 @@ struct FenwickRURQ {
     }
     return sum;
   }
+  // Returns a[l] + ... + a[r].
+  // Complexity: optimized, but sitll O(log n)
+  // Assumes that: 1 <= l <= r <= n.
+  int64_t fast_range_sum(int l, int r) const {
+    // The result is r * S1(r) - S2(r) - (l - 1) * S1(l - 1) + S2(l - 1). Walk
+    // down from r and l - 1 together until the walks meet, the rest of the
+    // path is shared.
+    int64_t rsum1 = 0;
+    int64_t lsum1 = 0;
+    int64_t sum2 = 0;
+    int i = r;
+    int j = l - 1;
+    while (i != j) {
+      if (i > j) {
+        rsum1 += T[i].t1;
+        sum2 += T[i].t2;
+        i -= i & -i;
+      } else {
+        lsum1 += T[j].t1;
+        sum2 -= T[j].t2;
+        j -= j & -j;
+      }
+    }
+    // On the shared path the T2 terms cancel out, while the T1 terms remain
+    // weighted by r - (l - 1).
+    int64_t common1 = 0;
+    for (; i >= 1; i -= i & -i) {
+      common1 += T[i].t1;
+    }
+    return rsum1 * r - lsum1 * (l - 1) + common1 * (r - l + 1) - sum2;
+  }
+  // Returns the smallest k, such that a[1] + ... + a[k] is GEQ than val on
+  // success. Returns n + 1 if the total sum is smaller.
+  // Complexity: O(log^2 n)
+  // Note: This only works if the cumulative sums are nondecreasing!
+  int search(int64_t val) const {
+    int lo = 1;
+    int hi = n + 1;
+    while (lo < hi) {
+      int mid = lo + (hi - lo) / 2;
+      if (prefix_sum(mid) >= val) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+  // Returns the smallest k, such that a[1] + ... + a[k] is GEQ than val on
+  // success. Returns n + 1 if the total sum is smaller.
+  // Complexity: O(log n)
+  // Note: This only works if the cumulative sums are nondecreasing!
+  int fast_search(int64_t val) const {
+    int i = 0;
+    int64_t sum1 = 0;
+    int64_t sum2 = 0;
+    // Descend like Fenwick::fast_search, but the prefix sum at a candidate ii
+    // is only known as a whole, S1(ii) * ii - S2(ii).
+    for (int mask = (n + 1) >> 1; mask != 0; mask >>= 1) {
+      int ii = i + mask;
+      if (ii > n) {
+        continue;
+      }
+      int64_t ii_sum1 = sum1 + T[ii].t1;
+      int64_t ii_sum2 = sum2 + T[ii].t2;
+      if (ii_sum1 * ii - ii_sum2 < val) {
+        sum1 = ii_sum1;
+        sum2 = ii_sum2;
+        i = ii;
+      }
+    }
+    return i + 1;
+  }
+  // Returns a[idx]. Since T1 is the tree of the difference array, this is a
+  // single walk over T1 only.
+  // Complexity: O(log n)
+  // Assumes that: 1 <= idx <= n.
+  int64_t access(int idx) const {
+    int64_t sum = 0;
+    for (; idx >= 1; idx -= idx & -idx) {
+      sum += T[idx].t1;
+    }
+    return sum;
+  }
 
   // Size of the trees and the fictive array.
   int n;
-  // The two fenwick trees.
-  Fenwick* T1;
-  Fenwick* T2;
+  // The two fenwick trees, T1 and T2, interleaved.
+  Node* T;
 };
 
 }  // namespace fenwick
@@ -19,10 +19,12 @@
 // SOFTWARE.
 
 #include <algorithm>
+#include <cassert>
 #include <cstdio>
 #include <cstdlib>
 #include <functional>
 #include <random>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -30,32 +32,139 @@
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 
+#include "benchmark_bytes.h"
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "benchmark_perf.h"
 #include "fenwick_rurq.h"
 
 using fenwick::FenwickRURQ;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::PerfCounters;
+using fenwick::bench::down_walk;
+using fenwick::bench::print_bytes;
+using fenwick::bench::print_counters;
+using fenwick::bench::print_memory;
+using fenwick::bench::keep;
+using fenwick::bench::up_walk;
 
 ////////////////////////////////////////////////////////////////////////////////
 // MEASUREMENT METHODS
 ////////////////////////////////////////////////////////////////////////////////
 
+// #define VERIFY
+
+// Count hardware events (see benchmark_perf.h) around each measured loop and
+// report them per operation.
+// #define PERF_COUNTERS
+#ifdef PERF_COUNTERS
+  constexpr bool kPerfCounters = true;
+#else
+  constexpr bool kPerfCounters = false;
+#endif
+
+// Report the memory footprint of every order, and the bytes the operations
+// touch (see benchmark_bytes.h) together with the bandwidth that amounts to.
+// #define BYTES
+#ifdef BYTES
+  constexpr bool kBytes = true;
+#else
+  constexpr bool kBytes = false;
+#endif
+
+// Bytes prefix_sum(idx) and update(l, r, ...) touch. The update walks up from
+// l and r + 1 until they meet, and on together.
+int64_t prefix_sum_bytes(int idx) {
+  return down_walk(idx) * sizeof(FenwickRURQ::Node);
+}
+int64_t update_bytes(const FenwickRURQ& ft, int l, int r) {
+  int nodes = 0;
+  int i = l;
+  int j = r + 1;
+  while (i != j) {
+    if (i < j) {
+      if (i > ft.n) break;
+      nodes++;
+      i += i & -i;
+    } else {
+      if (j > ft.n) break;
+      nodes++;
+      j += j & -j;
+    }
+  }
+  if (i == j) {
+    nodes += up_walk(i, ft.n);
+  }
+  return nodes * sizeof(FenwickRURQ::Node);
+}
+
 absl::Duration measure_prefix_sum(FenwickRURQ* ft, int ntc,
-                                  std::function<int64_t()> idx_gen) {
+                                  std::function<int64_t()> idx_gen,
+                                  PerfCounters* perf, double* bytes) {
   // Generate ntc indexes to query.
   std::vector<int> idxs;
   for (int i = 0; i < ntc; i++) {
     idxs.push_back(idx_gen());
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->prefix_sum(idxs[tc]);
+    keep(ft->prefix_sum(idxs[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += prefix_sum_bytes(idxs[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
   return duration / ntc;
 }
 
 absl::Duration measure_range_sum(FenwickRURQ* ft, int ntc,
-                                 std::function<int()> idx_gen) {
+                                 std::function<int()> idx_gen,
+                                 PerfCounters* perf, double* bytes) {
+  // Generate.
+  std::vector<int> ls;
+  std::vector<int> rs;
+  for (int i = 0; i < ntc; i++) {
+    int l = idx_gen();
+    int r = idx_gen();
+    if (l > r) {
+      std::swap(l, r);
+    }
+    ls.push_back(l);
+    rs.push_back(r);
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    #ifndef VERIFY
+      keep(ft->range_sum(ls[tc], rs[tc]));
+    #else
+      assert(ft->range_sum(ls[tc], rs[tc]) ==
+             ft->fast_range_sum(ls[tc], rs[tc]));
+    #endif
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += prefix_sum_bytes(rs[tc]) + prefix_sum_bytes(ls[tc] - 1);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
+  return duration / ntc;
+}
+
+absl::Duration measure_fast_range_sum(FenwickRURQ* ft, int ntc,
+                                      std::function<int()> idx_gen,
+                                      PerfCounters* perf) {
   // Generate.
   std::vector<int> ls;
   std::vector<int> rs;
@@ -69,17 +178,20 @@ absl::Duration measure_range_sum(FenwickRURQ* ft, int ntc,
     rs.push_back(r);
   }
   // Do the queries.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
-    ft->range_sum(ls[tc], rs[tc]);
+    keep(ft->fast_range_sum(ls[tc], rs[tc]));
   }
   auto duration = absl::Now() - start;
+  perf->stop();
   return duration / ntc;
 }
 
 absl::Duration measure_update(FenwickRURQ* ft, int ntc,
                               std::function<int()> idx_gen,
-                              std::function<int()> val_gen) {
+                              std::function<int()> val_gen,
+                              PerfCounters* perf, double* bytes) {
   // Generate.
   std::vector<int> ls;
   std::vector<int> rs;
@@ -95,11 +207,113 @@ absl::Duration measure_update(FenwickRURQ* ft, int ntc,
     vals.push_back(val_gen());
   }
   // Do the updates.
+  perf->start();
   auto start = absl::Now();
   for (int tc = 0; tc < ntc; tc++) {
     ft->update(ls[tc], rs[tc], vals[tc]);
   }
   auto duration = absl::Now() - start;
+  perf->stop();
+  if (kBytes) {
+    int64_t total = 0;
+    for (int tc = 0; tc < ntc; tc++) {
+      total += update_bytes(*ft, ls[tc], rs[tc]);
+    }
+    *bytes = 1.0 * total / ntc;
+  }
+  return duration / ntc;
+}
+
+absl::Duration measure_construct(FenwickRURQ* ft, int n, int ntc,
+                                 std::function<int64_t()> val_gen,
+                                 PerfCounters* perf) {
+  // Generate.
+  std::vector<int64_t*> arrays(ntc);
+  for (int64_t*& a : arrays) {
+    a = new int64_t[n + 1];
+    for (int i = 1; i <= n; i++) {
+      a[i] = val_gen();
+    }
+  }
+  // Do the constructions.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    ft->construct(arrays[tc]);
+    #ifdef VERIFY
+      for (int i = 1; i <= n; i++) {
+        assert(arrays[tc][i] == ft->access(i));
+        assert(arrays[tc][i] == ft->range_sum(i, i));
+      }
+    #endif
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
+  // Cleanup after construction.
+  for (int64_t*& a : arrays) {
+    delete[] a;
+  }
+  return duration / ntc;
+}
+
+absl::Duration measure_access(FenwickRURQ* ft, int ntc,
+                              std::function<int()> idx_gen,
+                              PerfCounters* perf) {
+  // Generate.
+  std::vector<int> idxs;
+  for (int i = 0; i < ntc; i++) {
+    idxs.push_back(idx_gen());
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->access(idxs[tc]));
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
+  return duration / ntc;
+}
+
+absl::Duration measure_search(FenwickRURQ* ft, int ntc,
+                              std::function<int64_t()> search_gen,
+                              PerfCounters* perf) {
+  // Generate ntc values to search for.
+  std::vector<int64_t> vals;
+  for (int i = 0; i < ntc; i++) {
+    vals.push_back(search_gen());
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    #ifndef VERIFY
+      keep(ft->search(vals[tc]));
+    #else
+      assert(ft->search(vals[tc]) == ft->fast_search(vals[tc]));
+    #endif
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
+  return duration / ntc;
+}
+
+absl::Duration measure_fast_search(FenwickRURQ* ft, int ntc,
+                                   std::function<int64_t()> search_gen,
+                                   PerfCounters* perf) {
+  // Generate ntc values to search for.
+  std::vector<int64_t> vals;
+  for (int i = 0; i < ntc; i++) {
+    vals.push_back(search_gen());
+  }
+  // Do the queries.
+  perf->start();
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->fast_search(vals[tc]));
+  }
+  auto duration = absl::Now() - start;
+  perf->stop();
   return duration / ntc;
 }
 
@@ -116,8 +330,19 @@ const std::unordered_map<int, int> kNumEachPerOrder {
 };
 
 // #define PLOT_DUMP
+#ifdef PLOT_DUMP
+  constexpr bool kPlotDump = true;
+#else
+  constexpr bool kPlotDump = false;
+#endif
 
-int main() {
+int main(int argc, char** argv) {
+  IndexPattern pattern;
+  if (!IndexPattern::from_args(argc, argv, &pattern)) {
+    fprintf(stderr, "Usage: %s [--pattern=%s]\n", argv[0],
+            IndexPattern::kUsage);
+    return 1;
+  }
   std::random_device rd;
   std::mt19937 prng(rd());
   std::uniform_int_distribution<int64_t> elem_dist(0, kMaxVal);
@@ -131,12 +356,14 @@ int main() {
     #endif
     FenwickRURQ ft(order);
     int n = (1 << order) - 1;
-    std::uniform_int_distribution<int> idx_dist(1, n);
-    auto idx_gen = [&]() { return idx_dist(prng); };
+    print_memory(ft.memory_bytes(), kBytes, kPlotDump);
+    auto idx_gen = pattern.make(n, &prng);
     const int kNumEach = kNumEachPerOrder.at(order);
     // 1) Prefix Sum
     {
-      auto duration = measure_prefix_sum(&ft, kNumEach, idx_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_prefix_sum(&ft, kNumEach, idx_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x prefix_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -144,10 +371,15 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 2) Update
     {
-      auto duration = measure_update(&ft, kNumEach, idx_gen, val_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration =
+          measure_update(&ft, kNumEach, idx_gen, val_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x update: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -155,10 +387,14 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     // 3) Range Sum
     {
-      auto duration = measure_range_sum(&ft, kNumEach, idx_gen);
+      PerfCounters perf(kPerfCounters);
+      double bytes = 0;
+      auto duration = measure_range_sum(&ft, kNumEach, idx_gen, &perf, &bytes);
       #ifndef PLOT_DUMP
         auto msg = absl::Substitute("$0 x range_sum: $1: ", kNumEach,
                                     absl::FormatDuration(duration));
@@ -166,6 +402,82 @@ int main() {
       #else
         printf("%15.3lf\t", ToDoubleNanoseconds(duration));
       #endif
+      print_bytes(bytes, duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 4) Fast Range Sum
+    {
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_fast_range_sum(&ft, kNumEach, idx_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x fast_range_sum: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 5) Construction
+    {
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_construct(&ft, n, kNumEach, val_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x construct: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      // One pass over a, two over the nodes.
+      print_bytes(1.0 * n * (sizeof(int64_t) + 2 * sizeof(FenwickRURQ::Node)),
+                  duration, kBytes, kPlotDump);
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 6) Access
+    {
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_access(&ft, kNumEach, idx_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x access: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 7) Search
+    {
+      std::uniform_int_distribution<int64_t> search_dist(
+          1, ft.prefix_sum(n) * 2);
+      auto search_gen = [&]() { return search_dist(prng); };
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_search(&ft, kNumEach, search_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x search: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
+    }
+    // 8) Fast Search
+    {
+      std::uniform_int_distribution<int64_t> search_dist(
+          1, ft.prefix_sum(n) * 2);
+      auto search_gen = [&]() { return search_dist(prng); };
+      PerfCounters perf(kPerfCounters);
+      auto duration = measure_fast_search(&ft, kNumEach, search_gen, &perf);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x fast_search: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+      print_counters(perf, kNumEach, kPerfCounters, kPlotDump);
     }
     printf("\n");
   }
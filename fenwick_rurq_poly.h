@@ -0,0 +1,214 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef FENWICK_RURQ_POLY_H_
+#define FENWICK_RURQ_POLY_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+
+namespace fenwick {
+
+// Implements a structure consisting of K + 2 interleaved Fenwick trees to
+// solve the range-update range-query variation of the Dynamic Partial Sums
+// problem, where an update adds a degree K polynomial to a range:
+//   a[x] += c[0] + c[1] * (x - l) + ... + c[K] * (x - l)^K, l <= x <= r.
+// FenwickRURQ is the K = 0 case.
+//
+// The prefix sum a[1] + ... + a[x] is a degree K + 1 polynomial in x on every
+// stretch between update endpoints, so the trees keep the coefficients of
+// that polynomial, scaled by (K + 1)! to keep them integral. The arithmetic
+// is done modulo 2^64, so results are exact as long as (K + 1)! times every
+// prefix sum fits in int64_t.
+template <int K>
+struct FenwickRURQPoly {
+  static_assert(K >= 0, "FenwickRURQPoly needs a nonnegative degree.");
+
+  // Coefficients of the update polynomial, in powers of (x - l).
+  using Coefs = std::array<int64_t, K + 1>;
+  // A node of all the trees, the coefficients of x^0, ..., x^(K + 1).
+  struct Node {
+    uint64_t c[K + 2];
+  };
+
+  // This structure can be normally constructed.
+  explicit FenwickRURQPoly(int m) {
+    n = (1 << m) - 1;
+    T = reinterpret_cast<Node*>(malloc((n + 1) * sizeof(Node)));
+    clear();
+  }
+
+  // Disable other copying ans assigning.
+  FenwickRURQPoly(const FenwickRURQPoly&) = delete;
+  void operator=(const FenwickRURQPoly&) = delete;
+
+  ~FenwickRURQPoly() { free(T); }
+
+  // Sets all array elements to 0.
+  void clear() { std::fill_n(T, n + 1, Node{}); }
+
+  // Adds c[0] + c[1] * (x - l) + ... + c[K] * (x - l)^K to all a[x] where
+  // l <= x <= r.
+  // Complexity: O(K^2 + K log n)
+  // Assumes that: 1 <= l <= r <= n.
+  void update(int l, int r, const Coefs& c) {
+    // G(x) = (K + 1)! * (p(l) + ... + p(x)), for x >= l - 1.
+    uint64_t g[K + 2];
+    cumulative(c, g);
+    shift(g, l);
+    // At l, the prefix sums start following G, at r + 1 they stop at G(r).
+    for (int i = l; i <= n; i += i & -i) {
+      for (int e = 0; e <= K + 1; e++) {
+        T[i].c[e] += g[e];
+      }
+    }
+    if (r < n) {
+      uint64_t gr = eval(g, r);
+      for (int i = r + 1; i <= n; i += i & -i) {
+        for (int e = 0; e <= K + 1; e++) {
+          T[i].c[e] -= g[e];
+        }
+        T[i].c[0] += gr;
+      }
+    }
+  }
+  // Returns a[1] + ... + a[idx].
+  // Complexity: O(K log n)
+  // Assumes that: 1 <= idx <= n.
+  int64_t prefix_sum(int idx) const {
+    uint64_t sum[K + 2] = {};
+    for (int i = idx; i >= 1; i -= i & -i) {
+      for (int e = 0; e <= K + 1; e++) {
+        sum[e] += T[i].c[e];
+      }
+    }
+    return static_cast<int64_t>(eval(sum, idx)) / kScale;
+  }
+  // Returns a[l] + ... + a[r].
+  // Complexity: O(K log n)
+  // Assumes that: 1 <= l <= r <= n.
+  int64_t range_sum(int l, int r) const {
+    int64_t sum = prefix_sum(r);
+    if (l > 1) {
+      sum -= prefix_sum(l - 1);
+    }
+    return sum;
+  }
+
+  // (K + 1)!, the scale of all the stored coefficients.
+  static constexpr int64_t factorial(int k) {
+    return k <= 1 ? 1 : k * factorial(k - 1);
+  }
+  static constexpr int64_t kScale = factorial(K + 1);
+
+  // Size of the trees and the fictive array.
+  int n;
+  // The K + 2 fenwick trees, interleaved.
+  Node* T;
+
+ private:
+  // Computes the coefficients of H(t) = (K + 1)! * (p(0) + ... + p(t)) in
+  // powers of t, where p(t) = c[0] + c[1] * t + ... + c[K] * t^K.
+  // Writes t^j through Stirling numbers of the second kind as a sum of
+  // m! * S(j, m) * C(t, m), and sums those with C(0, m) + ... + C(t, m) =
+  // C(t + 1, m + 1).
+  static void cumulative(const Coefs& c, uint64_t* h) {
+    // b[m] is the coefficient of C(t, m) in p(t).
+    uint64_t b[K + 1] = {};
+    uint64_t stirling[K + 1][K + 1] = {};
+    stirling[0][0] = 1;
+    for (int j = 1; j <= K; j++) {
+      for (int m = 1; m <= j; m++) {
+        stirling[j][m] = m * stirling[j - 1][m] + stirling[j - 1][m - 1];
+      }
+    }
+    for (int j = 0; j <= K; j++) {
+      uint64_t mfact = 1;
+      for (int m = 0; m <= j; m++) {
+        if (m > 0) mfact *= m;
+        b[m] += static_cast<uint64_t>(c[j]) * stirling[j][m] * mfact;
+      }
+    }
+    // Add b[m] * (K + 1)! / (m + 1)! * (t + 1) * t * ... * (t + 1 - m).
+    std::fill_n(h, K + 2, 0ULL);
+    uint64_t falling[K + 2] = {1};
+    for (int m = 0; m <= K; m++) {
+      // Multiply falling by (t + 1 - m).
+      for (int e = m + 1; e >= 1; e--) {
+        falling[e] = falling[e - 1] + falling[e] * (1 - m);
+      }
+      falling[0] *= 1 - m;
+      uint64_t scale = b[m] * static_cast<uint64_t>(kScale / factorial(m + 1));
+      for (int e = 0; e <= m + 1; e++) {
+        h[e] += scale * falling[e];
+      }
+    }
+  }
+
+  // Replaces the coefficients of h(t) with the ones of h(x - l) in powers of x.
+  static void shift(uint64_t* h, int l) {
+    uint64_t neg_l = -static_cast<uint64_t>(l);
+    // Taylor shift by repeated synthetic division.
+    for (int i = 0; i <= K; i++) {
+      for (int e = K; e >= i; e--) {
+        h[e] += neg_l * h[e + 1];
+      }
+    }
+  }
+
+  // Evaluates the polynomial with coefficients h at x.
+  static uint64_t eval(const uint64_t* h, int x) {
+    uint64_t res = 0;
+    for (int e = K + 1; e >= 0; e--) {
+      res = res * static_cast<uint64_t>(x) + h[e];
+    }
+    return res;
+  }
+};
+
+// The linear and the quadratic updates skip the general Stirling expansion.
+// With t = x - l:
+//   2 * (p(0) + ... + p(t)) = c1 t^2 + (2 c0 + c1) t + 2 c0
+template <>
+inline void FenwickRURQPoly<1>::cumulative(const Coefs& c, uint64_t* h) {
+  uint64_t c0 = c[0];
+  uint64_t c1 = c[1];
+  h[0] = 2 * c0;
+  h[1] = 2 * c0 + c1;
+  h[2] = c1;
+}
+//   6 * (p(0) + ... + p(t)) =
+//       2 c2 t^3 + (3 c1 + 3 c2) t^2 + (6 c0 + 3 c1 + c2) t + 6 c0
+template <>
+inline void FenwickRURQPoly<2>::cumulative(const Coefs& c, uint64_t* h) {
+  uint64_t c0 = c[0];
+  uint64_t c1 = c[1];
+  uint64_t c2 = c[2];
+  h[0] = 6 * c0;
+  h[1] = 6 * c0 + 3 * c1 + c2;
+  h[2] = 3 * c1 + 3 * c2;
+  h[3] = 2 * c2;
+}
+
+}  // namespace fenwick
+
+#endif  // FENWICK_RURQ_POLY_H_
@@ -0,0 +1,187 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "benchmark_latency.h"
+#include "fenwick_rurq_poly.h"
+
+using fenwick::FenwickRURQPoly;
+using fenwick::bench::keep;
+
+////////////////////////////////////////////////////////////////////////////////
+// MEASUREMENT METHODS
+////////////////////////////////////////////////////////////////////////////////
+
+template <int K>
+absl::Duration measure_prefix_sum(FenwickRURQPoly<K>* ft, int ntc,
+                                  std::function<int()> idx_gen) {
+  // Generate ntc indexes to query.
+  std::vector<int> idxs;
+  for (int i = 0; i < ntc; i++) {
+    idxs.push_back(idx_gen());
+  }
+  // Do the queries.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->prefix_sum(idxs[tc]));
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+template <int K>
+absl::Duration measure_range_sum(FenwickRURQPoly<K>* ft, int ntc,
+                                 std::function<int()> idx_gen) {
+  // Generate.
+  std::vector<int> ls;
+  std::vector<int> rs;
+  for (int i = 0; i < ntc; i++) {
+    int l = idx_gen();
+    int r = idx_gen();
+    if (l > r) {
+      std::swap(l, r);
+    }
+    ls.push_back(l);
+    rs.push_back(r);
+  }
+  // Do the queries.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    keep(ft->range_sum(ls[tc], rs[tc]));
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+template <int K>
+absl::Duration measure_update(FenwickRURQPoly<K>* ft, int ntc,
+                              std::function<int()> idx_gen,
+                              std::function<int()> val_gen) {
+  // Generate.
+  std::vector<int> ls;
+  std::vector<int> rs;
+  std::vector<typename FenwickRURQPoly<K>::Coefs> coefs(ntc);
+  for (int i = 0; i < ntc; i++) {
+    int l = idx_gen();
+    int r = idx_gen();
+    if (l > r) {
+      std::swap(l, r);
+    }
+    ls.push_back(l);
+    rs.push_back(r);
+    for (int64_t& c : coefs[i]) {
+      c = val_gen();
+    }
+  }
+  // Do the updates.
+  auto start = absl::Now();
+  for (int tc = 0; tc < ntc; tc++) {
+    ft->update(ls[tc], rs[tc], coefs[tc]);
+  }
+  auto duration = absl::Now() - start;
+  return duration / ntc;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+// Kept small, so that (K + 1)! * prefix sums fit in int64_t for K <= 2.
+constexpr int64_t kMaxVal = 10;
+constexpr int kMinOrder = 7;
+constexpr int kMaxOrder = 24;
+const std::unordered_map<int, int> kNumEachPerOrder {
+  { 7, 10000}, { 8, 10000}, { 9, 10000}, {10, 10000}, {11, 10000}, {12,  1000},
+  {13,  1000}, {14,  1000}, {15,  1000}, {16,  1000}, {17,   800}, {18,   500},
+  {19,   100}, {20,   100}, {21,   100}, {22,   100}, {23,   100}, {24,   100},
+  {25,    50}, {26,    50}, {27,    50}, {28,    50}, {29,    50}, {30,    50},
+};
+
+// #define PLOT_DUMP
+
+template <int K>
+void run(std::mt19937& prng) {
+  std::uniform_int_distribution<int64_t> elem_dist(-kMaxVal, kMaxVal);
+  auto val_gen = [&]() { return elem_dist(prng); };
+
+  for (int order = kMinOrder; order <= kMaxOrder; order++) {
+    #ifndef PLOT_DUMP
+      printf("Degree: %d Order: %d\n", K, order);
+    #else
+      printf("%d\t%d\t", K, order);
+    #endif
+    FenwickRURQPoly<K> ft(order);
+    int n = (1 << order) - 1;
+    std::uniform_int_distribution<int> idx_dist(1, n);
+    auto idx_gen = [&]() { return idx_dist(prng); };
+    const int kNumEach = kNumEachPerOrder.at(order);
+    // 1) Prefix Sum
+    {
+      auto duration = measure_prefix_sum<K>(&ft, kNumEach, idx_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x prefix_sum: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    // 2) Update
+    {
+      auto duration = measure_update<K>(&ft, kNumEach, idx_gen, val_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x update: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    // 3) Range Sum
+    {
+      auto duration = measure_range_sum<K>(&ft, kNumEach, idx_gen);
+      #ifndef PLOT_DUMP
+        auto msg = absl::Substitute("$0 x range_sum: $1: ", kNumEach,
+                                    absl::FormatDuration(duration));
+        printf("  %s\n", msg.c_str());
+      #else
+        printf("%15.3lf\t", ToDoubleNanoseconds(duration));
+      #endif
+    }
+    printf("\n");
+  }
+}
+
+int main() {
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  run<1>(prng);
+  run<2>(prng);
+  return 0;
+}
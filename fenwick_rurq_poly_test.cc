@@ -0,0 +1,111 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "fenwick_rurq_poly.h"
+
+using fenwick::FenwickRURQPoly;
+
+constexpr int kNumTestCases = 200;
+constexpr int kNumSessions = 20;
+constexpr int kQueriesPerSession = 10;
+constexpr int kUpdatesPerSession = 10;
+
+// Small enough for (K + 1)! times every prefix sum to fit in int64_t for
+// K <= 4.
+constexpr int kMaxOrder = 7;
+constexpr int kMaxVal = 10;
+
+// Runs random polynomial range updates, prefix sums and range sums against
+// FenwickRURQPoly<K> and checks them against adding the polynomial to a plain
+// array element by element. K = 1 and K = 2 go through the specialized
+// cumulative sums, the others through the general expansion.
+template <int K>
+void test(std::mt19937& prng) {
+  std::uniform_int_distribution<int> mgen(1, kMaxOrder);
+  std::uniform_int_distribution<int64_t> vgen(-kMaxVal, kMaxVal);
+
+  for (int tc = 1; tc <= kNumTestCases; tc++) {
+    int m = mgen(prng);
+    FenwickRURQPoly<K> ft(m);
+    int n = ft.n;
+    std::uniform_int_distribution<int> igen(1, n);
+    std::vector<int64_t> a(n + 1, 0);
+    for (int s = 0; s < kNumSessions; s++) {
+      for (int u = 0; u < kUpdatesPerSession; u++) {
+        int l = igen(prng);
+        int r = igen(prng);
+        if (l > r) {
+          std::swap(l, r);
+        }
+        typename FenwickRURQPoly<K>::Coefs c;
+        for (int64_t& coef : c) {
+          coef = vgen(prng);
+        }
+        ft.update(l, r, c);
+        for (int x = l; x <= r; x++) {
+          int64_t p = 0;
+          for (int j = K; j >= 0; j--) {
+            p = p * (x - l) + c[j];
+          }
+          a[x] += p;
+        }
+      }
+      for (int q = 0; q < kQueriesPerSession; q++) {
+        int l = igen(prng);
+        int r = igen(prng);
+        if (l > r) {
+          std::swap(l, r);
+        }
+        int64_t prefix = 0;
+        int64_t sol = 0;
+        for (int x = 1; x <= r; x++) {
+          prefix += a[x];
+          if (x >= l) {
+            sol += a[x];
+          }
+        }
+        assert(ft.prefix_sum(r) == prefix);
+        assert(ft.range_sum(l, r) == sol);
+      }
+    }
+    ft.clear();
+    assert(ft.prefix_sum(n) == 0);
+  }
+}
+
+int main() {
+  std::random_device rd;
+  std::mt19937 prng(rd());
+  test<0>(prng);
+  test<1>(prng);
+  test<2>(prng);
+  test<3>(prng);
+  test<4>(prng);
+  printf("Success!\n");
+  return 0;
+}
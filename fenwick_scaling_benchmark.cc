@@ -0,0 +1,284 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "absl/strings/substitute.h"
+#include "absl/synchronization/blocking_counter.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/synchronization/notification.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "benchmark_workload.h"
+
+using fenwick::bench::FenwickWorkload;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::LatencyHistogram;
+using fenwick::bench::Op;
+using fenwick::bench::RMQWorkload;
+using fenwick::bench::RURQWorkload;
+using fenwick::bench::apply_ops;
+using fenwick::bench::gen_ops;
+using fenwick::bench::keep;
+using fenwick::bench::parse_flags;
+using fenwick::bench::parse_mix;
+
+// Runs a mixed workload (see benchmark_workload.h) on 1..N threads, pinned to
+// cores, against either one instance shared by all the threads (guarded by a
+// reader-writer lock taken per batch) or one instance per thread (sharded, no
+// locking). For every structure, order, mode and thread count it reports the
+// aggregate throughput, the mean time per operation of the average and the
+// slowest thread, and p50 / p99 of the batch latency.
+//
+// With sharded instances the threads share nothing but the memory system, so
+// where the aggregate throughput stops growing with the threads at large
+// orders, the memory bandwidth is saturated.
+//
+// The structures name their operations differently, rmq reads through query
+// rather than prefix_sum and range_sum. With --structure=all, a --mix is only
+// run on the structures that have all of it's operations.
+
+struct Config {
+  std::string structure = "all";
+  int min_order = 12;
+  int max_order = 24;
+  int order_step = 4;
+  int max_threads = std::max(1u, std::thread::hardware_concurrency());
+  std::string mix;
+  int batch = 16;
+  int64_t ops = 200000;
+  bool pin = true;
+  IndexPattern pattern;
+};
+
+// Time every kLatencyPeriod-th batch.
+constexpr int kLatencyPeriod = 16;
+
+// Pins the calling thread to the given CPU. Returns false if it could not.
+bool pin_to_cpu(int cpu) {
+  #ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+  #else
+    (void)cpu;
+    return false;
+  #endif
+}
+
+#define PLOT_DUMP
+
+// Runs one configuration: threads threads, ops operations each, against one
+// shared instance or one instance per thread. The shared instance is built on
+// the calling thread. Each sharded one is built on it's own thread once that
+// is pinned, so first touch places it on the thread's NUMA node.
+template <typename Workload>
+void run_once(const Config& config, const std::vector<double>& weights,
+              int order, int threads, bool shared) {
+  std::random_device rd;
+  std::vector<std::unique_ptr<Workload>> workloads(shared ? 1 : threads);
+  if (shared) {
+    std::mt19937 prng(rd());
+    workloads[0].reset(new Workload(order, &prng));
+  }
+  std::vector<char> unpinned(threads, false);
+  absl::Mutex mu;
+  absl::BlockingCounter ready(threads);
+  absl::Notification go;
+  std::vector<absl::Duration> elapsed(threads);
+  std::vector<LatencyHistogram> hists(threads);
+  std::vector<std::thread> pool;
+  for (int t = 0; t < threads; t++) {
+    unsigned seed = rd();
+    unsigned build_seed = rd();
+    pool.emplace_back([&, t, seed, build_seed]() {
+      if (config.pin) {
+        unpinned[t] = !pin_to_cpu(
+            t % std::max(1u, std::thread::hardware_concurrency()));
+      }
+      if (!shared) {
+        std::mt19937 prng(build_seed);
+        workloads[t].reset(new Workload(order, &prng));
+      }
+      Workload* workload = workloads[shared ? 0 : t].get();
+      std::vector<Op> ops =
+          gen_ops(*workload, weights, config.pattern, config.ops, seed);
+      ready.DecrementCount();
+      go.WaitForNotification();
+      auto start = absl::Now();
+      keep(apply_ops(workload, ops, config.batch, shared ? &mu : nullptr,
+                     &hists[t], kLatencyPeriod));
+      elapsed[t] = absl::Now() - start;
+    });
+  }
+  ready.Wait();
+  auto start = absl::Now();
+  go.Notify();
+  for (auto& thread : pool) {
+    thread.join();
+  }
+  auto duration = absl::Now() - start;
+  int num_unpinned = std::count(unpinned.begin(), unpinned.end(), true);
+  if (num_unpinned > 0) {
+    fprintf(stderr,
+            "Warning: could not pin %d of %d thread(s), the row below is not "
+            "pinned\n",
+            num_unpinned, threads);
+  }
+
+  double ops_per_sec = config.ops * threads / absl::ToDoubleSeconds(duration);
+  absl::Duration mean;
+  absl::Duration slowest;
+  LatencyHistogram hist;
+  for (int t = 0; t < threads; t++) {
+    mean += elapsed[t] / config.ops / threads;
+    slowest = std::max(slowest, elapsed[t] / config.ops);
+    hist.merge(hists[t]);
+  }
+  const char* mode = shared ? "shared" : "sharded";
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "$0 $1 order $2, $3 thread(s): $4 ops/s, per op: $5 mean, $6 slowest "
+        "thread, batch of $7: p50: $8 p99: $9",
+        config.structure, mode, order, threads, ops_per_sec,
+        absl::FormatDuration(mean), absl::FormatDuration(slowest),
+        config.batch,
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.99))));
+    printf("%s\n", msg.c_str());
+  #else
+    printf("%s\t%s\t%d\t%d\t%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\n",
+           config.structure.c_str(), mode, order, threads, ops_per_sec,
+           ToDoubleNanoseconds(mean), ToDoubleNanoseconds(slowest),
+           hist.percentile(0.5), hist.percentile(0.99));
+  #endif
+  fflush(stdout);
+}
+
+// Sweeps orders, modes and thread counts for Workload. Returns false if the
+// mix is malformed.
+template <typename Workload>
+bool run(const Config& config) {
+  std::vector<double> weights;
+  std::string mix = config.mix.empty() ? Workload::kDefaultMix : config.mix;
+  if (!parse_mix<Workload>(mix, &weights)) {
+    fprintf(stderr, "Bad mix: %s\n", mix.c_str());
+    return false;
+  }
+  for (int order = config.min_order; order <= config.max_order;
+       order += config.order_step) {
+    for (bool shared : {true, false}) {
+      for (int threads = 1; threads <= config.max_threads; threads++) {
+        run_once<Workload>(config, weights, order, threads, shared);
+      }
+    }
+  }
+  return true;
+}
+
+// Runs Workload as run does. With all, a mix naming operations Workload lacks
+// skips it with a note instead of failing, and only the structures that ran
+// are counted in *runs.
+template <typename Workload>
+bool run_or_skip(const Config& config, bool all, int* runs) {
+  std::vector<double> weights;
+  if (all && !config.mix.empty() &&
+      !parse_mix<Workload>(config.mix, &weights)) {
+    fprintf(stderr, "Skipping %s, the mix names operations it lacks: %s\n",
+            config.structure.c_str(), config.mix.c_str());
+    return true;
+  }
+  (*runs)++;
+  return run<Workload>(config);
+}
+
+// Parses the command line into config. Returns false on a bad argument.
+bool parse_args(int argc, char** argv, Config* config) {
+  if (!parse_flags(argc, argv,
+                   {{"structure", &config->structure},
+                    {"min_order", &config->min_order},
+                    {"max_order", &config->max_order},
+                    {"order_step", &config->order_step},
+                    {"max_threads", &config->max_threads},
+                    {"mix", &config->mix},
+                    {"batch", &config->batch},
+                    {"ops", &config->ops},
+                    {"pin", &config->pin},
+                    {"pattern", &config->pattern}})) {
+    return false;
+  }
+  return config->min_order >= 1 && config->max_order <= 30 &&
+         config->order_step >= 1 && config->max_threads >= 1 &&
+         config->batch >= 1 && config->ops >= 1;
+}
+
+int main(int argc, char** argv) {
+  Config config;
+  if (!parse_args(argc, argv, &config)) {
+    fprintf(stderr,
+            "Usage: %s [--structure=all|fenwick|rurq|rmq] [--min_order=12] "
+            "[--max_order=24] [--order_step=4] [--max_threads=<cpus>] "
+            "[--mix=op:weight,...] [--batch=16] [--ops=200000] [--pin=1] "
+            "[--pattern=%s]\n",
+            argv[0], IndexPattern::kUsage);
+    return 1;
+  }
+  const std::string structure = config.structure;
+  bool all = structure == "all";
+  if (!all && structure != "fenwick" && structure != "rurq" &&
+      structure != "rmq") {
+    fprintf(stderr, "Unknown structure: %s\n", structure.c_str());
+    return 1;
+  }
+  bool ok = true;
+  int runs = 0;
+  if (all || structure == "fenwick") {
+    config.structure = "fenwick";
+    ok = ok && run_or_skip<FenwickWorkload>(config, all, &runs);
+  }
+  if (all || structure == "rurq") {
+    config.structure = "rurq";
+    ok = ok && run_or_skip<RURQWorkload>(config, all, &runs);
+  }
+  if (all || structure == "rmq") {
+    config.structure = "rmq";
+    ok = ok && run_or_skip<RMQWorkload>(config, all, &runs);
+  }
+  if (ok && runs == 0) {
+    fprintf(stderr, "Bad mix: %s\n", config.mix.c_str());
+    ok = false;
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,860 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "fenwick.h"
+#include "fenwick_2d.h"
+#include "fenwick_2d_sparse.h"
+#include "fenwick_nd.h"
+#include "fenwick_rmq.h"
+#include "fenwick_rmq_window.h"
+#include "fenwick_rurq.h"
+#include "fenwick_rurq_poly.h"
+
+using fenwick::Fenwick;
+using fenwick::Fenwick2D;
+using fenwick::Fenwick2DSparse;
+using fenwick::FenwickND;
+using fenwick::FenwickRURQ;
+using fenwick::FenwickRURQPoly;
+using FenwickRMQ = fenwick::rmq::FenwickRMQ<>;
+using FenwickRMQWindow = fenwick::rmq::FenwickRMQWindow<>;
+
+// Unified suite for all the structures, one benchmark per operation and
+// order. Unlike the per-structure *_benchmark binaries, which dump a table for
+// plotting, this one is meant for tracking regressions, e.g.
+//   fenwick_suite_benchmark --benchmark_repetitions=10
+//       --benchmark_out=report.json --benchmark_out_format=json
+// Use --benchmark_filter to pick structures, operations or orders.
+
+////////////////////////////////////////////////////////////////////////////////
+// INPUT GENERATION
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr int64_t kMaxVal = 1000;
+constexpr int kRmqMaxVal = 1 << 30;
+// Operation arguments are pregenerated into a ring of this size.
+constexpr int kNumArgs = 1 << 12;
+constexpr int kArgsMask = kNumArgs - 1;
+// Fixed, so that runs of different builds see the same inputs.
+constexpr unsigned kSeed = 2018;
+
+// Generates kNumArgs values in [lo, hi].
+template <typename T>
+std::vector<T> uniform_args(T lo, T hi, unsigned seed) {
+  std::mt19937 prng(seed);
+  std::uniform_int_distribution<T> dist(lo, hi);
+  std::vector<T> args(kNumArgs);
+  for (T& arg : args) {
+    arg = dist(prng);
+  }
+  return args;
+}
+
+// Generates kNumArgs ranges [ls[k], rs[k]] within [1, n], from seed and
+// seed + 1.
+void range_args(int n, unsigned seed, std::vector<int>* ls,
+                std::vector<int>* rs) {
+  *ls = uniform_args(1, n, seed);
+  *rs = uniform_args(1, n, seed + 1);
+  for (int k = 0; k < kNumArgs; k++) {
+    if ((*ls)[k] > (*rs)[k]) {
+      std::swap((*ls)[k], (*rs)[k]);
+    }
+  }
+}
+
+// Returns a[0..n] with random a[1..n].
+std::vector<int64_t> random_array(int n) {
+  std::mt19937 prng(kSeed);
+  std::uniform_int_distribution<int64_t> dist(0, kMaxVal);
+  std::vector<int64_t> a(n + 1, 0LL);
+  for (int i = 1; i <= n; i++) {
+    a[i] = dist(prng);
+  }
+  return a;
+}
+
+// Returns a Fenwick tree of order m over a random array. Delete with free(3).
+Fenwick* random_fenwick(int m) {
+  Fenwick* ft = Fenwick::allocate(m);
+  std::vector<int64_t> a = random_array(ft->n);
+  ft->fast_construct(a.data());
+  return ft;
+}
+
+// Orders to run the benchmarks of each structure at.
+void Orders1D(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(7, 27);
+}
+void Orders2D(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(7, 13);
+}
+void Orders3D(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(3, 8);
+}
+void Orders4D(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(3, 6);
+}
+// FenwickRURQPoly nodes hold K + 2 values, 2^27 of them would not fit.
+void OrdersPoly(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(7, 24);
+}
+// For Fenwick2DSparse, log2 of the number of points.
+void OrdersSparse(benchmark::internal::Benchmark* b) {
+  b->ArgName("order")->DenseRange(7, 22);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK
+////////////////////////////////////////////////////////////////////////////////
+
+void BM_Fenwick_PrefixSum(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> idxs = uniform_args(1, ft->n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft->prefix_sum(idxs[k++ & kArgsMask]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_PrefixSum)->Apply(Orders1D);
+
+void BM_Fenwick_Update(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> idxs = uniform_args(1, ft->n, kSeed);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft->update(idxs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_Update)->Apply(Orders1D);
+
+void BM_Fenwick_Construct(benchmark::State& state) {
+  Fenwick* ft = Fenwick::allocate(state.range(0));
+  std::vector<int64_t> a = random_array(ft->n);
+  for (auto _ : state) {
+    ft->construct(a.data());
+    benchmark::ClobberMemory();
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_Construct)->Apply(Orders1D);
+
+void BM_Fenwick_FastConstruct(benchmark::State& state) {
+  Fenwick* ft = Fenwick::allocate(state.range(0));
+  std::vector<int64_t> a = random_array(ft->n);
+  std::vector<int64_t> work(a.size());
+  for (auto _ : state) {
+    // fast_construct turns it's input into cumulative sums.
+    state.PauseTiming();
+    std::memcpy(work.data(), a.data(), a.size() * sizeof(int64_t));
+    state.ResumeTiming();
+    ft->fast_construct(work.data());
+    benchmark::ClobberMemory();
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_FastConstruct)->Apply(Orders1D);
+
+void BM_Fenwick_Access(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> idxs = uniform_args(1, ft->n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft->access(idxs[k++ & kArgsMask]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_Access)->Apply(Orders1D);
+
+void BM_Fenwick_FastAccess(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> idxs = uniform_args(1, ft->n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft->fast_access(idxs[k++ & kArgsMask]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_FastAccess)->Apply(Orders1D);
+
+void BM_Fenwick_FastSearch(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int64_t> vals =
+      uniform_args(int64_t(1), ft->prefix_sum(ft->n), kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft->fast_search(vals[k++ & kArgsMask]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_FastSearch)->Apply(Orders1D);
+
+void BM_Fenwick_RangeSum(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> ls, rs;
+  range_args(ft->n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft->range_sum(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_RangeSum)->Apply(Orders1D);
+
+void BM_Fenwick_FastRangeSum(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> ls, rs;
+  range_args(ft->n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft->fast_range_sum(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_FastRangeSum)->Apply(Orders1D);
+
+void BM_Fenwick_RupqUpdate(benchmark::State& state) {
+  Fenwick* ft = random_fenwick(state.range(0));
+  std::vector<int> ls, rs;
+  range_args(ft->n, kSeed, &ls, &rs);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft->rupq_update(ls[k & kArgsMask], rs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+  free(ft);
+}
+BENCHMARK(BM_Fenwick_RupqUpdate)->Apply(Orders1D);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK 2D
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns a 2D Fenwick tree of order m with kNumArgs random point updates
+// applied. Delete with free(3).
+Fenwick2D* random_fenwick_2d(int m) {
+  Fenwick2D* ft = Fenwick2D::allocate(m);
+  std::vector<int> xs = uniform_args(1, ft->n, kSeed + 2);
+  std::vector<int> ys = uniform_args(1, ft->n, kSeed + 3);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  for (int k = 0; k < kNumArgs; k++) {
+    ft->update(xs[k], ys[k], vals[k]);
+  }
+  return ft;
+}
+
+void BM_Fenwick2D_PrefixSum(benchmark::State& state) {
+  Fenwick2D* ft = random_fenwick_2d(state.range(0));
+  std::vector<int> xs = uniform_args(1, ft->n, kSeed);
+  std::vector<int> ys = uniform_args(1, ft->n, kSeed + 1);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft->prefix_sum(xs[k & kArgsMask], ys[k & kArgsMask]));
+    k++;
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick2D_PrefixSum)->Apply(Orders2D);
+
+void BM_Fenwick2D_Update(benchmark::State& state) {
+  Fenwick2D* ft = random_fenwick_2d(state.range(0));
+  std::vector<int> xs = uniform_args(1, ft->n, kSeed);
+  std::vector<int> ys = uniform_args(1, ft->n, kSeed + 1);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft->update(xs[k & kArgsMask], ys[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+  free(ft);
+}
+BENCHMARK(BM_Fenwick2D_Update)->Apply(Orders2D);
+
+void BM_Fenwick2D_RangeSum(benchmark::State& state) {
+  Fenwick2D* ft = random_fenwick_2d(state.range(0));
+  // The y ranges come from their own seeds, independent of the x ones.
+  std::vector<int> x1s, x2s, y1s, y2s;
+  range_args(ft->n, kSeed, &x1s, &x2s);
+  range_args(ft->n, kSeed + 2, &y1s, &y2s);
+  int k = 0;
+  for (auto _ : state) {
+    int q = k++ & kArgsMask;
+    benchmark::DoNotOptimize(ft->range_sum(x1s[q], y1s[q], x2s[q], y2s[q]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick2D_RangeSum)->Apply(Orders2D);
+
+void BM_Fenwick2D_FastSearch(benchmark::State& state) {
+  Fenwick2D* ft = random_fenwick_2d(state.range(0));
+  std::vector<int> y1s, y2s;
+  range_args(ft->n, kSeed, &y1s, &y2s);
+  std::vector<int64_t> vals =
+      uniform_args(int64_t(1), ft->prefix_sum(ft->n, ft->n), kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    int q = k++ & kArgsMask;
+    benchmark::DoNotOptimize(ft->fast_search(y1s[q], y2s[q], vals[q]));
+  }
+  free(ft);
+}
+BENCHMARK(BM_Fenwick2D_FastSearch)->Apply(Orders2D);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK ND
+////////////////////////////////////////////////////////////////////////////////
+
+// Generates kNumArgs points in [1, n]^D, coordinate d from seed + d.
+template <int D>
+std::vector<std::array<int, D>> point_args(int n, unsigned seed) {
+  std::vector<std::array<int, D>> points(kNumArgs);
+  for (int d = 0; d < D; d++) {
+    std::vector<int> coords = uniform_args(1, n, seed + d);
+    for (int k = 0; k < kNumArgs; k++) {
+      points[k][d] = coords[k];
+    }
+  }
+  return points;
+}
+
+// Returns a D-dimensional Fenwick tree of order m with kNumArgs random point
+// updates applied. Delete with free(3).
+template <int D>
+FenwickND<D, int64_t>* random_fenwick_nd(int m) {
+  auto* ft = FenwickND<D, int64_t>::allocate(m);
+  std::vector<std::array<int, D>> idxs = point_args<D>(ft->n, kSeed + 2);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  for (int k = 0; k < kNumArgs; k++) {
+    ft->update(idxs[k], vals[k]);
+  }
+  return ft;
+}
+
+template <int D>
+void BM_FenwickND_PrefixSum(benchmark::State& state) {
+  auto* ft = random_fenwick_nd<D>(state.range(0));
+  std::vector<std::array<int, D>> idxs = point_args<D>(ft->n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft->prefix_sum(idxs[k++ & kArgsMask]));
+  }
+  free(ft);
+}
+BENCHMARK_TEMPLATE(BM_FenwickND_PrefixSum, 3)->Apply(Orders3D);
+BENCHMARK_TEMPLATE(BM_FenwickND_PrefixSum, 4)->Apply(Orders4D);
+
+template <int D>
+void BM_FenwickND_Update(benchmark::State& state) {
+  auto* ft = random_fenwick_nd<D>(state.range(0));
+  std::vector<std::array<int, D>> idxs = point_args<D>(ft->n, kSeed);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft->update(idxs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+  free(ft);
+}
+BENCHMARK_TEMPLATE(BM_FenwickND_Update, 3)->Apply(Orders3D);
+BENCHMARK_TEMPLATE(BM_FenwickND_Update, 4)->Apply(Orders4D);
+
+template <int D>
+void BM_FenwickND_RangeSum(benchmark::State& state) {
+  auto* ft = random_fenwick_nd<D>(state.range(0));
+  // The corners come from seeds kSeed, ... and kSeed + D, ..., independent of
+  // each other.
+  std::vector<std::array<int, D>> los = point_args<D>(ft->n, kSeed);
+  std::vector<std::array<int, D>> his = point_args<D>(ft->n, kSeed + D);
+  for (int k = 0; k < kNumArgs; k++) {
+    for (int d = 0; d < D; d++) {
+      if (los[k][d] > his[k][d]) {
+        std::swap(los[k][d], his[k][d]);
+      }
+    }
+  }
+  int k = 0;
+  for (auto _ : state) {
+    int q = k++ & kArgsMask;
+    benchmark::DoNotOptimize(ft->range_sum(los[q], his[q]));
+  }
+  free(ft);
+}
+BENCHMARK_TEMPLATE(BM_FenwickND_RangeSum, 3)->Apply(Orders3D);
+BENCHMARK_TEMPLATE(BM_FenwickND_RangeSum, 4)->Apply(Orders4D);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK 2D SPARSE
+////////////////////////////////////////////////////////////////////////////////
+
+constexpr int kMaxCoord = 1000000000;
+
+// Generates 2^m random points with coordinates in [1, kMaxCoord].
+std::vector<std::pair<int, int>> random_points(int m) {
+  std::mt19937 prng(kSeed);
+  std::uniform_int_distribution<int> dist(1, kMaxCoord);
+  std::vector<std::pair<int, int>> points(1 << m);
+  for (auto& p : points) {
+    p.first = dist(prng);
+    p.second = dist(prng);
+  }
+  return points;
+}
+
+// Picks kNumArgs of the points, those are the ones update accepts.
+std::vector<std::pair<int, int>> point_picks(
+    const std::vector<std::pair<int, int>>& points, unsigned seed) {
+  std::vector<int> picks =
+      uniform_args(0, static_cast<int>(points.size()) - 1, seed);
+  std::vector<std::pair<int, int>> args(kNumArgs);
+  for (int k = 0; k < kNumArgs; k++) {
+    args[k] = points[picks[k]];
+  }
+  return args;
+}
+
+void BM_Fenwick2DSparse_Construct(benchmark::State& state) {
+  std::vector<std::pair<int, int>> points = random_points(state.range(0));
+  for (auto _ : state) {
+    Fenwick2DSparse ft(points);
+    benchmark::DoNotOptimize(ft.ys.data());
+  }
+}
+BENCHMARK(BM_Fenwick2DSparse_Construct)->Apply(OrdersSparse);
+
+void BM_Fenwick2DSparse_Update(benchmark::State& state) {
+  std::vector<std::pair<int, int>> points = random_points(state.range(0));
+  Fenwick2DSparse ft(points);
+  std::vector<std::pair<int, int>> args = point_picks(points, kSeed);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    int q = k++ & kArgsMask;
+    ft.update(args[q].first, args[q].second, vals[q]);
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_Fenwick2DSparse_Update)->Apply(OrdersSparse);
+
+void BM_Fenwick2DSparse_PrefixSum(benchmark::State& state) {
+  std::vector<std::pair<int, int>> points = random_points(state.range(0));
+  Fenwick2DSparse ft(points);
+  std::vector<std::pair<int, int>> updates = point_picks(points, kSeed + 2);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  for (int k = 0; k < kNumArgs; k++) {
+    ft.update(updates[k].first, updates[k].second, vals[k]);
+  }
+  // Queries at arbitrary coordinates, not only at the points.
+  std::vector<int> xs = uniform_args(1, kMaxCoord, kSeed);
+  std::vector<int> ys = uniform_args(1, kMaxCoord, kSeed + 1);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft.prefix_sum(xs[k & kArgsMask], ys[k & kArgsMask]));
+    k++;
+  }
+}
+BENCHMARK(BM_Fenwick2DSparse_PrefixSum)->Apply(OrdersSparse);
+
+void BM_Fenwick2DSparse_RangeSum(benchmark::State& state) {
+  std::vector<std::pair<int, int>> points = random_points(state.range(0));
+  Fenwick2DSparse ft(points);
+  std::vector<std::pair<int, int>> updates = point_picks(points, kSeed + 2);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  for (int k = 0; k < kNumArgs; k++) {
+    ft.update(updates[k].first, updates[k].second, vals[k]);
+  }
+  std::vector<int> x1s, x2s, y1s, y2s;
+  range_args(kMaxCoord, kSeed, &x1s, &x2s);
+  range_args(kMaxCoord, kSeed + 2, &y1s, &y2s);
+  int k = 0;
+  for (auto _ : state) {
+    int q = k++ & kArgsMask;
+    benchmark::DoNotOptimize(ft.range_sum(x1s[q], y1s[q], x2s[q], y2s[q]));
+  }
+}
+BENCHMARK(BM_Fenwick2DSparse_RangeSum)->Apply(OrdersSparse);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK RURQ
+////////////////////////////////////////////////////////////////////////////////
+
+void BM_FenwickRURQ_Update(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  std::vector<int> ls, rs;
+  range_args(ft.n, kSeed, &ls, &rs);
+  std::vector<int64_t> vals = uniform_args(int64_t(0), kMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft.update(ls[k & kArgsMask], rs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_FenwickRURQ_Update)->Apply(Orders1D);
+
+void BM_FenwickRURQ_Construct(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  std::vector<int64_t> a = random_array(ft.n);
+  for (auto _ : state) {
+    ft.construct(a.data());
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FenwickRURQ_Construct)->Apply(Orders1D);
+
+void BM_FenwickRURQ_PrefixSum(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  ft.construct(random_array(ft.n).data());
+  std::vector<int> idxs = uniform_args(1, ft.n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft.prefix_sum(idxs[k++ & kArgsMask]));
+  }
+}
+BENCHMARK(BM_FenwickRURQ_PrefixSum)->Apply(Orders1D);
+
+void BM_FenwickRURQ_RangeSum(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  ft.construct(random_array(ft.n).data());
+  std::vector<int> ls, rs;
+  range_args(ft.n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft.range_sum(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+}
+BENCHMARK(BM_FenwickRURQ_RangeSum)->Apply(Orders1D);
+
+void BM_FenwickRURQ_FastRangeSum(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  ft.construct(random_array(ft.n).data());
+  std::vector<int> ls, rs;
+  range_args(ft.n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft.fast_range_sum(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+}
+BENCHMARK(BM_FenwickRURQ_FastRangeSum)->Apply(Orders1D);
+
+void BM_FenwickRURQ_Access(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  ft.construct(random_array(ft.n).data());
+  std::vector<int> idxs = uniform_args(1, ft.n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft.access(idxs[k++ & kArgsMask]));
+  }
+}
+BENCHMARK(BM_FenwickRURQ_Access)->Apply(Orders1D);
+
+void BM_FenwickRURQ_FastSearch(benchmark::State& state) {
+  FenwickRURQ ft(state.range(0));
+  ft.construct(random_array(ft.n).data());
+  std::vector<int64_t> vals =
+      uniform_args(int64_t(1), ft.prefix_sum(ft.n), kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft.fast_search(vals[k++ & kArgsMask]));
+  }
+}
+BENCHMARK(BM_FenwickRURQ_FastSearch)->Apply(Orders1D);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK RURQ POLY
+////////////////////////////////////////////////////////////////////////////////
+
+// Generates kNumArgs polynomials of degree K with coefficients in
+// [-kMaxVal, kMaxVal].
+template <int K>
+std::vector<typename FenwickRURQPoly<K>::Coefs> coef_args(unsigned seed) {
+  std::vector<typename FenwickRURQPoly<K>::Coefs> args(kNumArgs);
+  for (int j = 0; j <= K; j++) {
+    std::vector<int64_t> cs = uniform_args(-kMaxVal, kMaxVal, seed + j);
+    for (int k = 0; k < kNumArgs; k++) {
+      args[k][j] = cs[k];
+    }
+  }
+  return args;
+}
+
+// Fills ft with kNumArgs random range updates.
+template <int K>
+void random_rurq_poly(FenwickRURQPoly<K>* ft) {
+  std::vector<int> ls, rs;
+  range_args(ft->n, kSeed + 2, &ls, &rs);
+  std::vector<typename FenwickRURQPoly<K>::Coefs> cs = coef_args<K>(kSeed);
+  for (int k = 0; k < kNumArgs; k++) {
+    ft->update(ls[k], rs[k], cs[k]);
+  }
+}
+
+template <int K>
+void BM_FenwickRURQPoly_Update(benchmark::State& state) {
+  FenwickRURQPoly<K> ft(state.range(0));
+  std::vector<int> ls, rs;
+  range_args(ft.n, kSeed, &ls, &rs);
+  std::vector<typename FenwickRURQPoly<K>::Coefs> cs = coef_args<K>(kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    ft.update(ls[k & kArgsMask], rs[k & kArgsMask], cs[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_Update, 1)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_Update, 2)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_Update, 3)->Apply(OrdersPoly);
+
+template <int K>
+void BM_FenwickRURQPoly_PrefixSum(benchmark::State& state) {
+  FenwickRURQPoly<K> ft(state.range(0));
+  random_rurq_poly(&ft);
+  std::vector<int> idxs = uniform_args(1, ft.n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ft.prefix_sum(idxs[k++ & kArgsMask]));
+  }
+}
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_PrefixSum, 1)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_PrefixSum, 2)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_PrefixSum, 3)->Apply(OrdersPoly);
+
+template <int K>
+void BM_FenwickRURQPoly_RangeSum(benchmark::State& state) {
+  FenwickRURQPoly<K> ft(state.range(0));
+  random_rurq_poly(&ft);
+  std::vector<int> ls, rs;
+  range_args(ft.n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        ft.range_sum(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+}
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_RangeSum, 1)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_RangeSum, 2)->Apply(OrdersPoly);
+BENCHMARK_TEMPLATE(BM_FenwickRURQPoly_RangeSum, 3)->Apply(OrdersPoly);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK RMQ
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns a[0..n] with random a[1..n].
+std::vector<int> random_rmq_array(int n) {
+  std::mt19937 prng(kSeed);
+  std::uniform_int_distribution<int> dist(0, kRmqMaxVal);
+  std::vector<int> a(n + 1);
+  for (int i = 1; i <= n; i++) {
+    a[i] = dist(prng);
+  }
+  return a;
+}
+
+// Fills rmq with random values.
+void random_rmq(FenwickRMQ* rmq) {
+  rmq->construct(random_rmq_array(rmq->n).data());
+}
+
+void BM_FenwickRMQ_Construct(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  std::vector<int> a = random_rmq_array(rmq.n);
+  for (auto _ : state) {
+    rmq.construct(a.data());
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_FenwickRMQ_Construct)->Apply(Orders1D);
+
+void BM_FenwickRMQ_Update(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> idxs = uniform_args(1, rmq.n, kSeed);
+  std::vector<int> vals = uniform_args(0, kRmqMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    rmq.update(idxs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_FenwickRMQ_Update)->Apply(Orders1D);
+
+void BM_FenwickRMQ_Query(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> ls, rs;
+  range_args(rmq.n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(rmq.query(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FenwickRMQ_Query)->Apply(Orders1D);
+
+void BM_FenwickRMQ_QueryBatch(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> ls, rs;
+  range_args(rmq.n, kSeed, &ls, &rs);
+  std::vector<int> res(kNumArgs);
+  for (auto _ : state) {
+    rmq.query_batch(kNumArgs, ls.data(), rs.data(), res.data());
+    benchmark::DoNotOptimize(res.data());
+  }
+  // Every iteration times a whole batch of kNumArgs queries. Like
+  // BM_FenwickRMQ_Query, report the queries per second in items_per_second,
+  // and the time per query in query_time.
+  state.SetItemsProcessed(state.iterations() * kNumArgs);
+  state.counters["query_time"] =
+      benchmark::Counter(state.iterations() * kNumArgs,
+                         benchmark::Counter::kIsRate |
+                             benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_FenwickRMQ_QueryBatch)->Apply(Orders1D);
+
+void BM_FenwickRMQ_QueryIndex(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> ls, rs;
+  range_args(rmq.n, kSeed, &ls, &rs);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        rmq.query_index(ls[k & kArgsMask], rs[k & kArgsMask]));
+    k++;
+  }
+}
+BENCHMARK(BM_FenwickRMQ_QueryIndex)->Apply(Orders1D);
+
+// The range updates are linear in the length of the range, short ranges of
+// at most kMaxRangeLen keep them comparable across the orders.
+constexpr int kMaxRangeLen = 1024;
+
+// Generates kNumArgs ranges [ls[k], rs[k]] within [1, n], of at most
+// kMaxRangeLen elements.
+void short_range_args(int n, unsigned seed, std::vector<int>* ls,
+                      std::vector<int>* rs) {
+  *ls = uniform_args(1, n, seed);
+  *rs = uniform_args(0, kMaxRangeLen - 1, seed + 1);
+  for (int k = 0; k < kNumArgs; k++) {
+    (*rs)[k] = std::min(n, (*ls)[k] + (*rs)[k]);
+  }
+}
+
+void BM_FenwickRMQ_RangeAssign(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> ls, rs;
+  short_range_args(rmq.n, kSeed, &ls, &rs);
+  std::vector<int> vals = uniform_args(0, kRmqMaxVal, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    rmq.range_assign(ls[k & kArgsMask], rs[k & kArgsMask], vals[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_FenwickRMQ_RangeAssign)->Apply(Orders1D);
+
+void BM_FenwickRMQ_RangeAdd(benchmark::State& state) {
+  FenwickRMQ rmq((1 << state.range(0)) - 1);
+  random_rmq(&rmq);
+  std::vector<int> ls, rs;
+  short_range_args(rmq.n, kSeed, &ls, &rs);
+  // Deltas of both signs, so the values drift without overflowing.
+  std::vector<int> deltas = uniform_args(-1000, 1000, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    rmq.range_add(ls[k & kArgsMask], rs[k & kArgsMask], deltas[k & kArgsMask]);
+    k++;
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_FenwickRMQ_RangeAdd)->Apply(Orders1D);
+
+////////////////////////////////////////////////////////////////////////////////
+// FENWICK RMQ WINDOW
+////////////////////////////////////////////////////////////////////////////////
+
+// Returns a window of 2^m - 1 slots, full of samples at consecutive times.
+FenwickRMQWindow random_window(int m) {
+  FenwickRMQWindow window((1 << m) - 1);
+  std::vector<int> vals = uniform_args(0, kRmqMaxVal, kSeed);
+  for (int t = 0; t < window.n; t++) {
+    window.push(t, vals[t & kArgsMask]);
+  }
+  return window;
+}
+
+void BM_FenwickRMQWindow_Push(benchmark::State& state) {
+  FenwickRMQWindow window = random_window(state.range(0));
+  std::vector<int> vals = uniform_args(0, kRmqMaxVal, kSeed + 1);
+  int k = 0;
+  for (auto _ : state) {
+    window.push(window.now + 1, vals[k++ & kArgsMask]);
+  }
+  benchmark::ClobberMemory();
+}
+BENCHMARK(BM_FenwickRMQWindow_Push)->Apply(Orders1D);
+
+void BM_FenwickRMQWindow_Last(benchmark::State& state) {
+  FenwickRMQWindow window = random_window(state.range(0));
+  std::vector<int> ws = uniform_args(1, window.n, kSeed);
+  int k = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(window.last(ws[k++ & kArgsMask]));
+  }
+}
+BENCHMARK(BM_FenwickRMQWindow_Last)->Apply(Orders1D);
+
+BENCHMARK_MAIN();
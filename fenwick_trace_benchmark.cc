@@ -0,0 +1,269 @@
+// Copyright (c) 2018 Viktor Slavkovic
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "absl/strings/substitute.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+#include "benchmark_index_gen.h"
+#include "benchmark_latency.h"
+#include "benchmark_trace.h"
+#include "benchmark_workload.h"
+
+using fenwick::bench::FenwickWorkload;
+using fenwick::bench::IndexPattern;
+using fenwick::bench::LatencyHistogram;
+using fenwick::bench::MappedTrace;
+using fenwick::bench::Op;
+using fenwick::bench::PrefixArray;
+using fenwick::bench::ReferenceWorkload;
+using fenwick::bench::RMQWorkload;
+using fenwick::bench::RURQWorkload;
+using fenwick::bench::SegmentTree;
+using fenwick::bench::SqrtBlocks;
+using fenwick::bench::TraceRecord;
+using fenwick::bench::TraceWriter;
+using fenwick::bench::gen_ops;
+using fenwick::bench::keep;
+using fenwick::bench::parse_flags;
+using fenwick::bench::parse_mix;
+using fenwick::bench::sample_latencies;
+
+// Records and replays operation traces (see benchmark_trace.h).
+//   fenwick_trace_benchmark --record=ops.trace --structure=fenwick
+//       --order=20 --mix=update:10,prefix_sum:90 --ops=1000000
+// writes a synthetic trace, the same mixes fenwick_mixed_benchmark runs.
+// Traces captured elsewhere with TraceWriter work the same.
+//   fenwick_trace_benchmark --replay=ops.trace --structure=segment_tree
+// runs a trace against one of the structures, single threaded, and reports
+// the throughput and the latency percentiles. A trace replays on any
+// structure that has all of its operations.
+
+struct Config {
+  std::string record;
+  std::string replay;
+  std::string structure = "fenwick";
+  int order = 20;
+  std::string mix;
+  int64_t ops = 1000000;
+  IndexPattern pattern;
+  int repeat = 1;
+};
+
+#define PLOT_DUMP
+
+// Time every kLatencyPeriod-th operation of the extra, sampled pass.
+constexpr int kLatencyPeriod = 16;
+
+// Maps the kinds of the trace to the ones of Workload, -1 where Workload lacks
+// the operation.
+template <typename Workload>
+void map_kinds(int* kinds) {
+  for (int k = 0; k < TraceRecord::kNumKinds; k++) {
+    kinds[k] = -1;
+    for (int w = 0; w < Workload::kNumOps; w++) {
+      if (strcmp(TraceRecord::kind_name(k), Workload::op_name(w)) == 0) {
+        kinds[k] = w;
+      }
+    }
+  }
+}
+
+// Generates the configured mix on Workload and writes it to config.record.
+template <typename Workload>
+bool record(const Config& config) {
+  std::vector<double> weights;
+  std::string mix = config.mix.empty() ? Workload::kDefaultMix : config.mix;
+  if (!parse_mix<Workload>(mix, &weights)) {
+    fprintf(stderr, "Bad mix: %s\n", mix.c_str());
+    return false;
+  }
+  int kinds[TraceRecord::kNumKinds];
+  map_kinds<Workload>(kinds);
+  std::random_device rd;
+  unsigned seed = rd();
+  std::mt19937 prng(seed);
+  Workload workload(config.order, &prng);
+  std::vector<Op> ops =
+      gen_ops(workload, weights, config.pattern, config.ops, rd());
+
+  TraceWriter writer;
+  if (!writer.open(config.record.c_str(), config.order, seed)) {
+    fprintf(stderr, "Can't write %s\n", config.record.c_str());
+    return false;
+  }
+  for (const Op& op : ops) {
+    int kind = 0;
+    while (kinds[kind] != op.kind) {
+      kind++;
+    }
+    writer.append(kind, op.a, op.b, op.val);
+  }
+  if (!writer.close()) {
+    fprintf(stderr, "Can't write %s\n", config.record.c_str());
+    return false;
+  }
+  printf("%s: %lld x ops of %s, order %d\n", config.record.c_str(),
+         static_cast<long long>(ops.size()), mix.c_str(), config.order);
+  return true;
+}
+
+// Replays config.replay on Workload config.repeat times, then once more with
+// every kLatencyPeriod-th operation timed. Returns false if the trace can't be
+// read or has operations Workload can't run.
+template <typename Workload>
+bool replay(const Config& config) {
+  MappedTrace trace;
+  const char* error;
+  if (!trace.open(config.replay.c_str(), &error)) {
+    fprintf(stderr, "Can't read %s: %s\n", config.replay.c_str(), error);
+    return false;
+  }
+  if (trace.header->count > INT_MAX) {
+    fprintf(stderr, "Traces are limited to %d records.\n", INT_MAX);
+    return false;
+  }
+  int count = trace.header->count;
+  std::mt19937 prng(trace.header->seed);
+  Workload workload(trace.header->order, &prng);
+
+  // Check everything upfront, the replay loop doesn't.
+  int kinds[TraceRecord::kNumKinds];
+  map_kinds<Workload>(kinds);
+  for (int i = 0; i < count; i++) {
+    const TraceRecord& r = trace.records[i];
+    if (!r.valid(workload.n())) {
+      fprintf(stderr, "Record %d is malformed.\n", i);
+      return false;
+    }
+    if (kinds[r.kind] < 0) {
+      fprintf(stderr, "Record %d: %s has no %s.\n", i,
+              config.structure.c_str(), TraceRecord::kind_name(r.kind));
+      return false;
+    }
+    if (r.kind == TraceRecord::kUpdate && !Workload::kRangeUpdates &&
+        r.a != r.b) {
+      fprintf(stderr, "Record %d: %s has no range updates.\n", i,
+              config.structure.c_str());
+      return false;
+    }
+  }
+  auto apply = [&](int i) {
+    const TraceRecord& r = trace.records[i];
+    return workload.apply(Op{kinds[r.kind], r.a, r.b, r.val});
+  };
+
+  int64_t sink = 0;
+  auto start = absl::Now();
+  for (int rep = 0; rep < config.repeat; rep++) {
+    for (int i = 0; i < count; i++) {
+      sink += apply(i);
+    }
+  }
+  auto duration = absl::Now() - start;
+  keep(sink);
+  LatencyHistogram hist;
+  sample_latencies(count, kLatencyPeriod, &hist, apply);
+
+  int64_t total = static_cast<int64_t>(count) * config.repeat;
+  double ops_per_sec = total / absl::ToDoubleSeconds(duration);
+  absl::Duration mean = duration / std::max<int64_t>(total, 1);
+  #ifndef PLOT_DUMP
+    auto msg = absl::Substitute(
+        "$0 order $1: $2 x ops in $3: $4 ops/s, per op: $5 mean, p50: $6 "
+        "p99: $7 p999: $8",
+        config.structure, trace.header->order, total,
+        absl::FormatDuration(duration), ops_per_sec, absl::FormatDuration(mean),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.5))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.99))),
+        absl::FormatDuration(absl::Nanoseconds(hist.percentile(0.999))));
+    printf("%s\n", msg.c_str());
+  #else
+    printf("%s\t%d\t%lld\t%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\t%15.3lf\n",
+           config.structure.c_str(), trace.header->order,
+           static_cast<long long>(total), ops_per_sec,
+           ToDoubleNanoseconds(mean), hist.percentile(0.5),
+           hist.percentile(0.99), hist.percentile(0.999));
+  #endif
+  return true;
+}
+
+template <typename Workload>
+bool run(const Config& config) {
+  return config.record.empty() ? replay<Workload>(config)
+                               : record<Workload>(config);
+}
+
+// Parses the command line into config. Returns false on a bad argument.
+bool parse_args(int argc, char** argv, Config* config) {
+  if (!parse_flags(argc, argv,
+                   {{"record", &config->record},
+                    {"replay", &config->replay},
+                    {"structure", &config->structure},
+                    {"order", &config->order},
+                    {"mix", &config->mix},
+                    {"ops", &config->ops},
+                    {"pattern", &config->pattern},
+                    {"repeat", &config->repeat}})) {
+    return false;
+  }
+  return config->record.empty() != config->replay.empty() &&
+         config->order >= 1 && config->order <= 30 && config->ops >= 1 &&
+         config->ops <= INT_MAX && config->repeat >= 1;
+}
+
+int main(int argc, char** argv) {
+  Config config;
+  if (!parse_args(argc, argv, &config)) {
+    fprintf(stderr,
+            "Usage: %s --record=FILE [--structure=fenwick] [--order=20] "
+            "[--mix=op:weight,...] [--ops=1000000] [--pattern=%s]\n"
+            "       %s --replay=FILE [--structure=fenwick] [--repeat=1]\n"
+            "Structures: fenwick|rurq|rmq|prefix_array|segment_tree|"
+            "sqrt_blocks\n",
+            argv[0], IndexPattern::kUsage, argv[0]);
+    return 1;
+  }
+  bool ok = false;
+  if (config.structure == "fenwick") {
+    ok = run<FenwickWorkload>(config);
+  } else if (config.structure == "rurq") {
+    ok = run<RURQWorkload>(config);
+  } else if (config.structure == "rmq") {
+    ok = run<RMQWorkload>(config);
+  } else if (config.structure == "prefix_array") {
+    ok = run<ReferenceWorkload<PrefixArray>>(config);
+  } else if (config.structure == "segment_tree") {
+    ok = run<ReferenceWorkload<SegmentTree>>(config);
+  } else if (config.structure == "sqrt_blocks") {
+    ok = run<ReferenceWorkload<SqrtBlocks>>(config);
+  } else {
+    fprintf(stderr, "Unknown structure: %s\n", config.structure.c_str());
+  }
+  return ok ? 0 : 1;
+}